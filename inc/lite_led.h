@@ -15,6 +15,8 @@
  *       * LED_MODE_FADE_IN   : Gradual fade-in
  *       * LED_MODE_FADE_OUT  : Gradual fade-out
  *       * LED_MODE_ALTERNATE : Alternate between two LEDs
+ *       * LED_MODE_SCRIPT    : Run a step sequence (set/ramp/hold/loop)
+ *       * LED_MODE_TRACK     : Play a keyframe brightness curve
  *   - Duration control (auto stop after timeout)
  *   - Custom brightness callback for hardware abstraction
  * 
@@ -47,6 +49,8 @@ extern "C" {
 #define LED_ERROR_PARA_INVALID      -1
 #define LED_ERROR_MODE_INVALID      -2
 #define LED_ERROR_ALTERNATE_ID      -3
+#define LED_ERROR_NO_MEMORY         -4
+#define LED_ERROR_NOT_REPLAYABLE    -5
 
 typedef void (*led_set_brt_f)(uint8_t percent);
 typedef void (*led_dur_timeout_f)(void);
@@ -59,6 +63,8 @@ typedef enum {
     LED_MODE_FADE_IN,
     LED_MODE_FADE_OUT,
     LED_MODE_ALTERNATE,
+    LED_MODE_SCRIPT,
+    LED_MODE_TRACK,
 } led_mode_e;
 
 typedef enum {
@@ -66,14 +72,76 @@ typedef enum {
     LED_STATE_ON,
 } led_state_e;
 
+typedef enum {
+    LED_STEP_SET = 0,   // Jump to percent
+    LED_STEP_RAMP,      // Linear ramp to percent within ms
+    LED_STEP_HOLD,      // Keep the current brightness for ms
+    LED_STEP_LOOP,      // Restart the script, ms = total runs (0 = forever)
+} led_step_op_e;
+
+typedef struct {
+    led_step_op_e op;
+    uint8_t percent;    // Target brightness (SET/RAMP)
+    uint32_t ms;        // Ramp/hold time in ms, run count for LOOP
+} led_step_t;
+
+// Step helpers, e.g. { LED_RAMP(80, 300), LED_HOLD(1000), LED_RAMP(0, 300), LED_LOOP(0) }
+#define LED_SET(p)          { LED_STEP_SET, (p), 0 }
+#define LED_RAMP(p, ms)     { LED_STEP_RAMP, (p), (ms) }
+#define LED_HOLD(ms)        { LED_STEP_HOLD, 0, (ms) }
+#define LED_LOOP(n)         { LED_STEP_LOOP, 0, (n) }
+
+typedef struct {
+    const led_step_t *steps;
+    uint16_t count;
+} led_script_t;
+
+// Script execution frame, allocated from LED_POOL_SCRIPT
+typedef struct led_script_frame led_script_frame_t;
+
+// Fixed-capacity object pools, optionally placed in a caller arena
+typedef enum {
+    LED_POOL_SCRIPT = 0,    // Script frames (LED_MODE_SCRIPT)
+
+    LED_POOL_MAX,
+} led_pool_e;
+
+typedef struct {
+    uint16_t capacity;      // Objects the arena holds
+    uint16_t used;          // Objects allocated now
+    uint16_t high_water;    // Most objects allocated at once
+    uint32_t fail_count;    // Allocations refused because the pool was full
+} led_pool_stats_t;
+
+typedef enum {
+    LED_INTERP_STEP = 0,    // Hold the key value until the next key
+    LED_INTERP_LINEAR,      // Straight line to the next key
+    LED_INTERP_EASE,        // Smoothstep to the next key
+} led_interp_e;
+
+typedef struct {
+    uint32_t ms;            // Key time from track start, ascending
+    uint8_t percent;        // Brightness at this key
+    led_interp_e interp;    // How to move from this key to the next one
+} led_keyframe_t;
+
 typedef struct {
-    led_mode_e mode;        /* LED mode: ON, OFF, BLINK, BREATH, FADE_IN, FADE_OUT, ALTERNATE */
+    const led_keyframe_t *keys;
+    uint16_t count;
+    bool loop;              // Wrap at the last key time instead of holding it
+} led_track_t;
+
+typedef struct {
+    led_mode_e mode;        /* LED mode: ON, OFF, BLINK, BREATH, FADE_IN, FADE_OUT, ALTERNATE, SCRIPT */
     led_id_e alter_id;      /* LED ID to pair with in ALTERNATE mode */
     uint32_t on_ms;         /* ON duration in milliseconds (for BLINK) */
     uint32_t off_ms;        /* OFF duration in milliseconds (for BLINK) */
     uint32_t fade_ms;       /* Fade duration in milliseconds (for BREATH/FADE_IN/FADE_OUT) */
     uint32_t alternate_ms;  /* Alternate mode period in milliseconds */
     uint32_t duration_ms;   /* Total duration in milliseconds (0 = infinite) */
+    const led_script_t *script; /* Step sequence (for SCRIPT), shareable between LEDs */
+    const led_track_t *track;   /* Keyframe track (for TRACK), shareable between LEDs */
+    uint32_t offset_ms;     /* Start position within the track in milliseconds */
 } led_cfg_t;
 
 typedef struct {
@@ -84,6 +152,10 @@ typedef struct {
     size_t fade_tick;
     size_t alternate_tick;
     size_t duration_tick;
+    const led_script_t *script;
+    const led_track_t *track;
+    float phase_step;       // BREATH/FADE phase step per tick, negative for FADE_OUT
+    uint32_t offset_ms;     // Start position within the track
 } led_inner_cfg_t;
 
 typedef struct {
@@ -94,6 +166,8 @@ typedef struct {
     float phase;        // Current phase
     float phase_step;   // Step per tick
     bool dur_timeout;
+    uint32_t track_ms;  // Position within the track
+    uint16_t track_key; // Cursor: key at or before track_ms
 } led_status_t;
 
 typedef struct {
@@ -102,14 +176,329 @@ typedef struct {
     led_status_t stat;
     led_set_brt_f set_percent_cb;
     led_dur_timeout_f dur_timeout_cb;
+#if LED_SCRIPT_ENABLE
+    led_script_frame_t *frame;
+#endif
+#if LED_CLOCK_ENABLE
+    led_clock_e clock;  // Clock domain the effect is timed against
+#endif
+#if LED_PULL_ENABLE
+    bool pull;                  // Evaluated on demand instead of every poll
+    uint64_t pull_start_q16;    // Clock time of the last write (Q16 ticks)
+#endif
+#if LED_GOV_ENABLE
+    bool low_priority;          // Deferred first when the poll is overloaded
+    uint32_t gov_tick;          // Poll the LED last ran in
+#if LED_CLOCK_ENABLE
+    uint64_t gov_time_q16;      // Clock time the LED last ran up to (Q16 ticks)
+#endif
+#endif
 } led_dev_t;
 
+// Brightness curve kernels for BREATH/FADE
+typedef enum {
+    LED_KERNEL_LUT = 0,     // Table lookup
+    LED_KERNEL_COSF,        // Single precision cosine
+    LED_KERNEL_COS,         // Double precision cosine
+    LED_KERNEL_LUT_HALF,    // Half-size table, odd entries interpolated
+    LED_KERNEL_POLY,        // Polynomial of the curve LED_BREATH_LUT_ENABLE selects
+
+    LED_KERNEL_MAX,
+} led_kernel_e;
+
+// Quality levels of the governor, each one includes the previous ones
+typedef enum {
+    LED_GOV_FULL = 0,       // Full quality
+    LED_GOV_NO_INTERP,      // Output interpolation off
+    LED_GOV_SLOW_HALF,      // BREATH/FADE computed every second poll
+    LED_GOV_DEFER_LOW,      // Low-priority LEDs updated every fourth poll
+
+    LED_GOV_LEVEL_MAX,
+} led_gov_level_e;
+
+typedef uint32_t (*led_time_us_f)(void);
+
+typedef struct {
+    uint32_t tick;          // Polls since start
+    uint64_t update_count;  // Brightness callbacks issued
+    uint64_t change_count;  // Callbacks that changed the brightness
+    led_kernel_e curve_kernel; // Brightness curve kernel in use
+    int16_t temp_dc;        // LED temperature, measured or estimated (0.1 degC)
+    uint8_t derate_percent; // Thermal derating applied to the output
+    uint64_t strip_bytes;   // Bytes handed to strip write callbacks
+    led_gov_level_e gov_level;  // Current quality level
+    uint8_t load_percent;   // Average poll cost in % of LED_POLL_PERIOD_MS
+    uint32_t poll_us;       // Average poll cost (us)
+    uint32_t gov_changes;   // Quality level changes
+    int32_t sync_error_us;  // Phase error at the last sync input, time base minus source
+    int32_t sync_ppm;       // Rate correction applied to the time base
+    bool sync_locked;       // Time base referenced to the sync source
+    uint32_t journal_dropped;   // Journal records lost to a full buffer
+    uint32_t journal_unsupported;   // Calls journaled that a replay cannot make
+    uint32_t journal_digest;    // Digest of the levels sent to the backends since the journal started
+} led_stats_t;
+
+#if LED_CONTEXT_ENABLE
+// Engine state: LEDs, effects and statistics. Opaque, lite_led_ctx_size() bytes.
+typedef struct led_ctx led_ctx_t;
+#endif
+
+#if LED_SIM_ENABLE
+typedef struct {
+    uint32_t ticks;           // Simulated polls
+    uint64_t sim_ms;          // Simulated time (ms)
+    uint64_t wall_us;         // Host CPU time spent (us)
+    uint64_t updates;         // Brightness updates
+    uint64_t changes;         // Updates that changed the brightness
+    uint64_t bytes;           // Bytes the headless backends would transmit
+    uint64_t updates_per_sec; // Aggregate LED update throughput
+    uint32_t speedup_x100;    // Simulated time / host time x100 (>=100: real time or faster)
+} led_sim_report_t;
+#endif
+
+// Journaled API calls. Events and schedule entries are journaled through
+// the calls they make.
+typedef enum {
+    LED_JOURNAL_WRITE = 0,      // lite_led_write()
+    LED_JOURNAL_MASTER,         // lite_led_set_master(), arg[0] = percent
+    LED_JOURNAL_CLOCK_SPEED,    // lite_led_clock_set_speed(), id = domain, arg[0] = permille
+    LED_JOURNAL_CLOCK_ATTACH,   // lite_led_clock_attach(), arg[0] = domain
+    LED_JOURNAL_END,            // lite_led_journal_stop(), tick = end, arg[0] = digest of the levels sent
+    LED_JOURNAL_INIT,           // lite_led_init(), also logged by lite_led_journal_start() per LED
+    LED_JOURNAL_PULL,           // lite_led_set_pull(), arg[0] = pull
+    LED_JOURNAL_PRIORITY,       // lite_led_set_priority(), arg[0] = low
+    LED_JOURNAL_KERNEL,         // lite_led_autotune(), arg[0] = kernel picked
+    LED_JOURNAL_LFO,            // lite_led_lfo_set(), id = LFO, arg[0] = shape, arg[1] = period ms
+    LED_JOURNAL_MOD_ROUTE,      // lite_led_mod_route(), id = route, arg[0..3] = LFO, LED, dest, depth
+    LED_JOURNAL_CCT_INIT,       // lite_led_cct_init(), id = pair, arg[0] = warm LED, arg[1] = cold LED
+    LED_JOURNAL_CCT_WRITE,      // lite_led_cct_write(), id = pair, arg[0] = CCT (K), arg[1] = fade ms
+    LED_JOURNAL_THERMAL,        // lite_led_thermal_set_temp(), arg[0] = temperature (0.1 degC, signed)
+    LED_JOURNAL_CHARLIE_ATTACH, // lite_led_charlie_attach(), arg[0] = anode, arg[1] = cathode
+    LED_JOURNAL_PALETTE_SET,    // lite_led_palette_set(), id = entry, arg[0..2] = r, g, b
+    LED_JOURNAL_PALETTE_BIND,   // lite_led_palette_bind(), id = entry, arg[0] = LED
+    LED_JOURNAL_STRIP_TRUNCATE, // lite_led_strip_truncate(), id = strip, arg[0] = enable
+    LED_JOURNAL_SCENE_RECALL,   // lite_led_scene_recall(), arg[0] = morph ms; SCENE_LED records follow
+    LED_JOURNAL_SCENE_LED,      // Entry of the scene recalled just before, in ticks
+    LED_JOURNAL_UNSUPPORTED,    // A call a replay cannot make, arg[0] = its op
+    // Calls that are only logged as UNSUPPORTED: they hand over buffers,
+    // pointers or host time
+    LED_JOURNAL_STRIP_INIT,     // lite_led_strip_init()
+    LED_JOURNAL_STRIP_SET,      // lite_led_strip_set()
+    LED_JOURNAL_STRIP_PORT,     // lite_led_strip_port_init()
+    LED_JOURNAL_CALIB_LOAD,     // lite_led_calib_load()
+    LED_JOURNAL_POOL_SETUP,     // lite_led_pool_setup()
+    LED_JOURNAL_SYNC,           // lite_led_sync_set_timer/pulse/stamp()
+    LED_JOURNAL_GOV_TIMER,      // lite_led_gov_set_timer()
+    // Calls logged for reference only: replaying them does nothing, the
+    // schedule entries that run are logged as the calls they make
+    LED_JOURNAL_SCHED_LOAD,     // lite_led_sched_load(), arg[0] = entries
+    LED_JOURNAL_SCHED_TIME,     // lite_led_sched_set_time(), id = weekday, arg[0] = seconds
+} led_journal_op_e;
+
+// One journaled call. Fixed size so that logging is a single store; a
+// journal file is an array of these in native byte order
+typedef struct {
+    uint32_t tick;      // Poll the call was made before
+    uint8_t op;         // led_journal_op_e
+    uint8_t id;         // LED ID, clock domain, or the index the call takes
+    uint8_t mode;       // WRITE/SCENE_LED: led_mode_e
+    uint8_t alter_id;   // WRITE/SCENE_LED: LED paired in ALTERNATE mode
+    uint32_t arg[6];    // WRITE: on, off, fade, alternate, duration, offset ms
+                        // SCENE_LED: on, off, fade, alternate, duration ticks, phase step (float bits)
+} led_journal_rec_t;
+
+// Receives a full journal buffer (e.g. to write it to a file or flash)
+typedef void (*led_journal_flush_f)(const led_journal_rec_t *recs, size_t count);
+
+typedef enum {
+    LED_LFO_SINE = 0,
+    LED_LFO_TRIANGLE,
+    LED_LFO_SQUARE,
+    LED_LFO_SAW,
+} led_lfo_shape_e;
+
+typedef enum {
+    LED_MOD_SPEED = 0,  // BREATH/FADE phase speed
+    LED_MOD_LEVEL,      // Output brightness
+} led_mod_dest_e;
+
+// Scene: a prebuilt effect per LED, filled by lite_led_scene_set/capture;
+// LEDs not used by the scene are left untouched
+typedef struct {
+    led_inner_cfg_t cfg[LED_NUM];
+    bool used[LED_NUM];
+} led_scene_t;
+
+typedef enum {
+    LED_SCHED_SCENE = 0,    // Recall scene, morphing over ms
+    LED_SCHED_MASTER,       // Set the master level to percent
+    LED_SCHED_WRITE,        // Write cfg to LED id
+} led_sched_action_e;
+
+typedef struct {
+    uint32_t time_s;        // Seconds since midnight, ascending in a schedule
+    uint8_t days;           // Weekday mask, bit 0 = Sunday, 0 = every day
+    led_sched_action_e action;
+    uint8_t id;             // LED (WRITE)
+    uint8_t percent;        // Master level (MASTER)
+    uint32_t ms;            // Morph time (SCENE)
+    const led_scene_t *scene;
+    const led_cfg_t *cfg;
+} led_sched_entry_t;
+
+#define LED_SCHED_TIME(h, m, s) ((uint32_t)(h) * 3600u + (uint32_t)(m) * 60u + (uint32_t)(s))
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} led_rgb_t;
+
+// Receives the wire bytes of a strip, 3 per pixel from the first pixel; a
+// truncating strip may get fewer pixels than it has
+typedef void (*led_strip_write_f)(const uint8_t *data, size_t len);
+
+// Pin state of a charlieplexed array: dir bit 1 = pin driven, 0 = Hi-Z
+typedef struct {
+    uint16_t dir;
+    uint16_t out;   // Level of driven pins
+} led_charlie_state_t;
+
 // ========== API ==========
 int lite_led_init(uint8_t id, led_set_brt_f cb);
 int lite_led_register_duration_timeout_cb(uint8_t id, led_dur_timeout_f cb);
 int lite_led_write(uint8_t id, const led_cfg_t *cfg);
 int lite_led_read(uint8_t id, led_status_t *status);
 void lite_led_poll_handle(void);
+int lite_led_get_stats(led_stats_t *stats);
+
+#if LED_OUTPUT_INTERP_ENABLE
+void lite_led_output_poll(void);
+#endif
+
+#if LED_GOV_ENABLE
+int lite_led_gov_set_timer(led_time_us_f now_us);
+int lite_led_set_priority(uint8_t id, bool low);
+#endif
+
+#if LED_AUTOTUNE_ENABLE
+int lite_led_autotune(uint32_t budget_ms);
+#endif
+
+#if LED_SCRIPT_ENABLE
+size_t lite_led_pool_obj_size(led_pool_e pool);
+int lite_led_pool_setup(led_pool_e pool, void *arena, size_t size);
+int lite_led_pool_get_stats(led_pool_e pool, led_pool_stats_t *stats);
+#endif
+
+#if LED_TRACK_ENABLE
+uint8_t lite_led_track_sample(const led_track_t *track, uint16_t *cursor, uint32_t ms);
+void lite_led_track_eval(const led_track_t *track, uint32_t ms, const uint32_t *offset_ms,
+                         uint16_t *cursor, uint8_t *out, size_t n);
+#endif
+
+#if LED_CHARLIE_ENABLE
+int lite_led_charlie_attach(uint8_t id, uint8_t anode, uint8_t cathode);
+size_t lite_led_charlie_schedule(const led_charlie_state_t **states);
+int lite_led_charlie_next(led_charlie_state_t *state);
+#endif
+
+#if LED_CALIB_ENABLE
+int lite_led_calib_load(const uint8_t *data, size_t len);
+#endif
+
+#if LED_MASTER_ENABLE
+int lite_led_set_master(uint8_t percent);
+#endif
+
+#if LED_THERMAL_ENABLE
+int lite_led_thermal_set_temp(int16_t temp_dc);
+#endif
+
+#if LED_CCT_ENABLE
+int lite_led_cct_init(uint8_t n, uint8_t warm_id, uint8_t cold_id);
+int lite_led_cct_write(uint8_t n, uint16_t cct_k, uint32_t fade_ms);
+#endif
+
+#if LED_PULL_ENABLE
+int lite_led_set_pull(uint8_t id, bool pull);
+int lite_led_sample(uint8_t id, uint8_t *percent);
+#endif
+
+#if LED_MOD_ENABLE
+int lite_led_lfo_set(uint8_t n, led_lfo_shape_e shape, uint32_t period_ms);
+int lite_led_mod_route(uint8_t n, uint8_t lfo, uint8_t id, led_mod_dest_e dest, uint8_t depth_percent);
+#endif
+
+#if LED_SCENE_ENABLE
+int lite_led_scene_recall(const led_scene_t *scene, uint32_t morph_ms);
+int lite_led_scene_set(led_scene_t *scene, uint8_t id, const led_cfg_t *cfg);
+int lite_led_scene_capture(led_scene_t *scene);
+#endif
+
+#if LED_SCHED_ENABLE
+int lite_led_sched_load(const led_sched_entry_t *entries, uint16_t count);
+int lite_led_sched_set_time(uint8_t weekday, uint32_t sec);
+#endif
+
+#if LED_STRIP_ENABLE
+int lite_led_strip_init(uint8_t n, uint8_t *pixels, uint8_t *frame, uint16_t count, led_strip_write_f cb);
+int lite_led_strip_truncate(uint8_t n, bool enable);
+int lite_led_strip_set(uint8_t n, uint16_t pos, const uint8_t *index, uint16_t len);
+int lite_led_palette_set(uint8_t index, led_rgb_t color);
+int lite_led_palette_bind(uint8_t index, uint8_t id);
+int lite_led_strip_port_init(uint8_t *buf, size_t size, led_strip_write_f cb);
+size_t lite_led_strip_encode(const uint8_t *const *frames, const size_t *lens, uint8_t num, size_t len, void *out);
+#endif
+
+#if LED_EVENT_ENABLE
+int lite_led_event_bind(uint16_t event, uint32_t led_mask, const led_cfg_t *cfg);
+int lite_led_event_unbind(uint16_t event);
+int lite_led_event_post(uint16_t event);
+#endif
+
+#if LED_CLOCK_ENABLE
+int lite_led_clock_attach(uint8_t id, led_clock_e clk);
+int lite_led_clock_set_speed(led_clock_e clk, uint32_t permille);
+int lite_led_clock_set_bpm(led_clock_e clk, uint16_t bpm);
+#endif
+
+#if LED_SYNC_ENABLE
+int lite_led_sync_set_timer(led_time_us_f now_us);
+int lite_led_sync_pulse(uint32_t stamp_us);
+int lite_led_sync_stamp(uint32_t source_ms, uint32_t stamp_us);
+#endif
+
+#if LED_PARALLEL_ENABLE
+void lite_led_poll_begin(void);
+bool lite_led_poll_work(void);
+void lite_led_poll_end(void);
+#endif
+
+#if LED_CONTEXT_ENABLE
+size_t lite_led_ctx_size(void);
+int lite_led_ctx_init(led_ctx_t *ctx);
+int lite_led_ctx_select(led_ctx_t *ctx);
+led_ctx_t *lite_led_ctx_current(void);
+#endif
+
+#if LED_JOURNAL_ENABLE
+int lite_led_journal_start(led_journal_rec_t *buf, size_t count, led_journal_flush_f cb);
+int lite_led_journal_stop(size_t *count);
+int lite_led_journal_apply(const led_journal_rec_t *rec, led_set_brt_f cb);
+#endif
+
+#if LED_SIM_ENABLE
+int lite_led_sim_init(void);
+int lite_led_sim_run(uint32_t ticks, led_sim_report_t *report);
+#if LED_CONTEXT_ENABLE
+int lite_led_site_start(led_ctx_t *const *ctx, size_t count);
+void lite_led_site_begin(void);
+bool lite_led_site_work(void);
+void lite_led_site_end(void);
+int lite_led_site_report(uint64_t wall_us, led_sim_report_t *report);
+#endif
+#endif
 
 #ifdef __cplusplus
 }
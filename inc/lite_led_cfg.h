@@ -27,6 +27,138 @@ extern "C" {
 // 1: use LUT for breath/fade, 0: use calculation
 #define LED_BREATH_LUT_ENABLE   (1)
 
+// 1: lite_led_autotune() may replace the above choice with the fastest kernel, 0: disable
+#define LED_AUTOTUNE_ENABLE     (0)
+
+// 1: split poll into chunks that several threads can claim, 0: single thread
+#define LED_PARALLEL_ENABLE     (0)
+// Number of LEDs per chunk claimed by a poll worker
+#define LED_PARALLEL_CHUNK      (16)
+
+// 1: let the application keep several engine contexts and pick one per thread (C11), 0: one built-in engine
+#define LED_CONTEXT_ENABLE      (0)
+
+// 1: enable headless simulation on a virtual clock, 0: disable
+#define LED_SIM_ENABLE          (0)
+// Bytes a real backend would transmit per brightness update
+#define LED_SIM_BYTES_PER_UPDATE (1)
+
+// 1: record API calls with their tick in a binary journal for replay, 0: disable
+#define LED_JOURNAL_ENABLE      (0)
+
+// 1: enable LED_MODE_SCRIPT step sequences, 0: disable
+#define LED_SCRIPT_ENABLE       (0)
+// Script frames in the built-in pool arena, used unless lite_led_pool_setup() gives one
+#define LED_SCRIPT_POOL_SIZE    (4)
+
+// 1: enable LED_MODE_TRACK keyframe curves, 0: disable
+#define LED_TRACK_ENABLE        (0)
+
+// 1: enable clock domains (BPM / speed factor), 0: all effects in real time
+#define LED_CLOCK_ENABLE        (0)
+// Tempo at which effects on a clock domain are authored
+#define LED_CLOCK_REF_BPM       (120)
+// Highest domain speed in permille
+#define LED_CLOCK_MAX_SPEED     (16000)
+
+// 1: lock the clock domains to an external sync source (needs LED_CLOCK_ENABLE), 0: disable
+#define LED_SYNC_ENABLE         (0)
+// Source time between two sync pulses (ms)
+#define LED_SYNC_PERIOD_MS      (1000)
+// Largest rate correction (ppm), kept small enough not to be seen
+#define LED_SYNC_MAX_PPM        (20000)
+// Phase errors above this re-reference the time base instead of slewing (ms)
+#define LED_SYNC_STEP_MS        (200)
+
+// 1: enable the event-to-effect binding table, 0: disable
+#define LED_EVENT_ENABLE        (0)
+// Number of event IDs (e.g. lite_button events) that can be bound
+#define LED_EVENT_NUM           (16)
+
+// 1: allow LEDs to be evaluated on demand (pull) instead of every poll, 0: disable
+#define LED_PULL_ENABLE         (0)
+
+// 1: enable the charlieplexed array backend, 0: disable
+#define LED_CHARLIE_ENABLE      (0)
+// Number of charlieplexing pins (<= 16)
+#define LED_CHARLIE_PIN_NUM     (5)
+// Sub-slots per LED in the pin schedule (brightness steps)
+#define LED_CHARLIE_LEVELS      (16)
+
+// 1: enable tunable-white (warm + cold) entities, 0: disable
+#define LED_CCT_ENABLE          (0)
+// Number of tunable-white entities
+#define LED_CCT_NUM             (1)
+// Color temperature of the warm and the cold channel (K)
+#define LED_CCT_MIN_K           (2700)
+#define LED_CCT_MAX_K           (6500)
+// Entries of the CCT-to-mix table
+#define LED_CCT_LUT_SIZE        (64)
+
+// 1: enable per-LED calibration folded into the output table, 0: disable
+#define LED_CALIB_ENABLE        (0)
+// Number of calibration bins (each costs 256 bytes of RAM)
+#define LED_CALIB_BIN_NUM       (4)
+
+// 1: enable the master level stage (folded into the output table), 0: disable
+#define LED_MASTER_ENABLE       (0)
+
+// 1: enable thermal derating through the master stage, 0: disable
+#define LED_THERMAL_ENABLE      (0)
+// Thermal model update period (ms)
+#define LED_THERMAL_PERIOD_MS   (1000)
+// Ambient temperature and steady-state rise at full output (0.1 degC)
+#define LED_THERMAL_AMBIENT_DC  (250)
+#define LED_THERMAL_RISE_DC     (500)
+// Thermal time constant of the fixture (ms)
+#define LED_THERMAL_TAU_MS      (60000)
+// Derating starts at START and reaches MIN_PERCENT at LIMIT (0.1 degC)
+#define LED_THERMAL_START_DC    (600)
+#define LED_THERMAL_LIMIT_DC    (850)
+#define LED_THERMAL_MIN_PERCENT (30)
+
+// 1: interpolate smooth effects at the output rate between polls, 0: disable
+#define LED_OUTPUT_INTERP_ENABLE (0)
+// Output update period (ms), a divisor of LED_POLL_PERIOD_MS
+#define LED_OUTPUT_PERIOD_MS    (10)
+
+// 1: enable LFO sources routed to effect parameters, 0: disable
+#define LED_MOD_ENABLE          (0)
+// Number of shared LFO sources and of routes
+#define LED_LFO_NUM             (4)
+#define LED_MOD_ROUTE_NUM       (8)
+
+// 1: enable scene recall with timed morphing, 0: disable
+#define LED_SCENE_ENABLE        (0)
+
+// 1: enable the time-of-day schedule, 0: disable
+#define LED_SCHED_ENABLE        (0)
+// Forward clock jumps up to this long run the skipped entries (s); longer
+// jumps and jumps back rebuild the state from the whole schedule instead
+#define LED_SCHED_CATCHUP_S     (300)
+
+// 1: enable the adaptive quality governor, 0: disable (runs once lite_led_gov_set_timer() gives it a clock)
+#define LED_GOV_ENABLE          (0)
+// Poll cost (% of LED_POLL_PERIOD_MS) above which quality is lowered, below which it is restored
+#define LED_GOV_HIGH_PERCENT    (80)
+#define LED_GOV_LOW_PERCENT     (40)
+// Minimum polls between two quality level changes
+#define LED_GOV_HOLD_TICKS      (20)
+
+// 1: enable palette-indexed pixel strips, 0: disable
+#define LED_STRIP_ENABLE        (0)
+// Number of strips (daisy chains), each with its own pixel buffer
+#define LED_STRIP_NUM           (2)
+// Wire byte offsets of R, G and B within a pixel (GRB for WS2812-type strips)
+#define LED_STRIP_R_OFS         (1)
+#define LED_STRIP_G_OFS         (0)
+#define LED_STRIP_B_OFS         (2)
+// Strips driven in parallel from one port (lite_led_strip_port_init): 8 or 16
+#define LED_STRIP_PORT_WIDTH    (8)
+
+// 1: count effect timers down in one pass and update only LEDs at an edge, 0: disable
+#define LED_TIMER_SCAN_ENABLE   (0)
+
 // LED ID list (update according to your hardware)
 typedef enum {
     LED_GREEN = 0,
@@ -38,6 +170,14 @@ typedef enum {
     LED_INVALID,
 } led_id_e;
 
+// Clock domain list (used when LED_CLOCK_ENABLE is 1)
+typedef enum {
+    LED_CLOCK_SYSTEM = 0,   // Default domain of every LED
+    LED_CLOCK_MUSIC,
+
+    LED_CLOCK_MAX,
+} led_clock_e;
+
 #ifdef __cplusplus
 }
 #endif
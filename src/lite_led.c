@@ -15,6 +15,17 @@
  *   - Tick-based timing (based on LED_POLL_PERIOD_MS).
  *   - Cosine-based brightness calculation for smooth breathing/fading.
  *   - Duration management (auto-stop after given time).
+ *   - Step scripts executed by the poll, frames from a fixed pool.
+ *   - O(1) fixed-capacity object pools, in a caller arena sized at init.
+ *   - Keyframe tracks with a per-LED cursor (O(1) per tick).
+ *   - Charlieplexed LED arrays driven from a precomputed pin schedule.
+ *   - Tunable-white pairs mixed from a color temperature table.
+ *   - Per-bin calibration folded into a single output table lookup.
+ *   - Prebuilt scenes recalled by pointer swap, optionally morphed from the current output.
+ *   - Time-of-day schedule that only compares one deadline per poll.
+ *   - Quality governor that trades smoothness for poll time under overload.
+ *   - Palette-indexed pixel strips rendered by one lookup per pixel.
+ *   - Parallel strip output bit-transposed 8 strips at a time in a 64-bit word.
  *
  * @author  HughWu
  * @date    2025-08-23
@@ -36,15 +47,508 @@
 
 #include "lite_led.h"
 
+#if LED_PARALLEL_ENABLE || LED_CONTEXT_ENABLE
+#include <stdatomic.h>
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 #define LED_PI        M_PI         // π
 #define LED_2PI       (2.0 * M_PI) // 2π
 
-static led_dev_t g_led_list[LED_NUM] = {0};
+#define LED_THERMAL_PERIOD_TICKS \
+    ((LED_THERMAL_PERIOD_MS / LED_POLL_PERIOD_MS) ? (LED_THERMAL_PERIOD_MS / LED_POLL_PERIOD_MS) : 1)
 
-#if LED_BREATH_LUT_ENABLE
+// Flags returned by lite_led_update()
+#define LED_UPDATE_PUSHED   (1u << 0)  // Brightness callback issued
+#define LED_UPDATE_CHANGED  (1u << 1)  // Brightness differs from last tick
+
+#if LED_SCRIPT_ENABLE
+struct led_script_frame {
+    const led_script_t *script;
+    uint16_t step;                  // Next step to execute
+    uint32_t runs;                  // Completed runs (for LOOP)
+    int32_t level_q8;               // Brightness during a ramp (Q8)
+    int32_t ramp_step_q8;           // Ramp increment per tick (Q8)
+    size_t ramp_tick;               // Remaining ramp ticks
+};
+
+#define LED_POOL_ALIGN      sizeof(void *)
+
+typedef struct {
+    uint8_t *base;          // Arena, NULL until the pool is first used
+    void *free;             // Free list, linked through the first word of each object
+    size_t stride;          // Object size rounded up to LED_POOL_ALIGN
+    led_pool_stats_t stats;
+} led_pool_t;
+
+typedef struct {
+    size_t obj_size;
+    size_t arena_ofs;       // Built-in arena in the engine state, used unless lite_led_pool_setup() gives one
+    size_t arena_size;
+} led_pool_def_t;
+#endif
+
+#if LED_CLOCK_ENABLE
+typedef struct {
+    uint32_t rate_q16;  // Domain ticks per poll (Q16, 1.0 = 65536)
+    uint32_t acc_q16;   // Fractional tick carried to the next poll
+    uint32_t steps;     // Whole domain ticks in the current poll
+    float scale;        // rate_q16 as float, for phase modes
+    uint64_t time_q16;  // Domain time since start (Q16 ticks)
+    uint64_t step_q16;  // Domain time at the start of the last poll that ticked
+    uint64_t base_q16;  // Domain time at the start of the last poll
+    uint32_t tick;      // Poll the domain was last advanced for
+    uint32_t gen;       // Bumped on every rate change
+} led_clock_t;
+#endif
+
+#if LED_SYNC_ENABLE
+#if !LED_CLOCK_ENABLE
+#error "LED_SYNC_ENABLE trims the clock domains, enable LED_CLOCK_ENABLE"
+#endif
+
+#define LED_SYNC_POLL_US    ((int64_t)LED_POLL_PERIOD_MS * 1000)
+#define LED_SYNC_KP_DIV     4   // Slew a quarter of the phase error per input
+#define LED_SYNC_KI_DIV     64  // Critically damped together with LED_SYNC_KP_DIV
+#endif
+
+#if LED_JOURNAL_ENABLE
+#define LED_JOURNAL_FNV_BASIS   2166136261u
+#define LED_JOURNAL_FNV_PRIME   16777619u
+#endif
+
+#if LED_EVENT_ENABLE
+#if LED_NUM > 32
+#error "LED_EVENT_ENABLE binds LEDs by a 32-bit mask, LED_NUM must be <= 32"
+#endif
+
+typedef struct {
+    uint32_t led_mask;  // Bit n set: apply cfg to LED n (0 = unbound)
+    led_cfg_t cfg;
+} led_binding_t;
+#endif
+
+#if LED_CHARLIE_ENABLE
+#if LED_CHARLIE_PIN_NUM > 16
+#error "LED_CHARLIE_PIN_NUM must be <= 16 (pin states are 16-bit masks)"
+#endif
+
+typedef struct {
+    uint8_t anode;      // Pin driven high
+    uint8_t cathode;    // Pin driven low
+    uint8_t duty;       // Lit sub-slots (0 ~ LED_CHARLIE_LEVELS)
+} led_charlie_slot_t;
+#endif
+
+#if LED_CCT_ENABLE
+typedef struct {
+    uint8_t warm_id;        // Carries the brightness effect
+    uint8_t cold_id;        // Slaved to the warm LED
+    uint32_t cct_q8;        // Current color temperature (K, Q8)
+    int32_t step_q8;        // CCT change per tick during a fade (K, Q8)
+    size_t fade_tick;       // Remaining fade ticks
+} led_cct_t;
+#endif
+
+#if LED_THERMAL_ENABLE && !LED_MASTER_ENABLE
+#error "LED_THERMAL_ENABLE derates through the master stage, enable LED_MASTER_ENABLE"
+#endif
+
+// The output stage reads a table when calibration or master scaling is on
+#define LED_OUT_LUT_ENABLE  (LED_CALIB_ENABLE || LED_MASTER_ENABLE)
+
+#if LED_CALIB_ENABLE
+#define LED_CALIB_MAGIC     "LLCB"
+#define LED_CALIB_VERSION   (1)
+#define LED_CALIB_HDR_SIZE  (8)
+#define LED_OUT_BIN_NUM     LED_CALIB_BIN_NUM
+#define LED_OUT_BIN(id)     (g_led_calib_bin[id])
+#else
+#define LED_OUT_BIN_NUM     (1)
+#define LED_OUT_BIN(id)     (0)
+#endif
+
+#if LED_OUTPUT_INTERP_ENABLE
+#define LED_OUTPUT_INTERP_STEPS  (LED_POLL_PERIOD_MS / LED_OUTPUT_PERIOD_MS)
+
+#if LED_OUTPUT_INTERP_STEPS < 1
+#error "LED_OUTPUT_PERIOD_MS must not be longer than LED_POLL_PERIOD_MS"
+#endif
+
+typedef struct {
+    uint16_t level_q8;  // Output level (percent, Q8)
+    int16_t step_q8;    // Change per output tick (percent, Q8)
+    uint8_t target;     // Key value being approached
+    uint8_t sent;       // Last value sent to the backends
+    uint8_t steps;      // Output ticks left to reach the target
+} led_interp_t;
+#endif
+
+#if LED_MOD_ENABLE
+typedef struct {
+    led_lfo_shape_e shape;
+    uint32_t phase_q16;     // Position in the cycle (Q16 of one period)
+    uint32_t step_q16;      // Advance per poll
+    float value;            // Current output, -1 ~ 1
+} led_lfo_t;
+
+typedef struct {
+    uint8_t lfo;            // Source
+    uint8_t id;             // Target LED
+    led_mod_dest_e dest;    // Target parameter
+    float depth;            // 0 ~ 1, 0 = route unused
+} led_mod_route_t;
+
+typedef struct {
+    float speed;            // Phase step multiplier
+    uint16_t level_q8;      // Brightness multiplier (Q8)
+    bool level_routed;      // Level follows a source, output every poll
+    bool refresh;           // Level just returned to neutral, output once
+} led_mod_t;
+#endif
+
+#if LED_SCHED_ENABLE
+#define LED_DAY_MS          (86400000u)
+#endif
+
+#if LED_GOV_ENABLE
+#define LED_GOV_EWMA_SHIFT  3   // Poll cost average over ~8 polls
+#endif
+
+#if LED_STRIP_ENABLE
+#define LED_PALETTE_SIZE    256
+
+typedef struct {
+    uint8_t *pixels;        // Palette index per pixel (caller buffer)
+    uint8_t *frame;         // Wire bytes, 3 per pixel (caller buffer)
+    uint16_t count;
+    led_strip_write_f write_cb;
+    uint16_t dirty_lo;      // First pixel changed since the last transmission
+    uint16_t dirty_hi;      // One past the last changed pixel, 0 = clean
+    bool truncate;          // Chain keeps the pixels past the end of a short frame
+} led_strip_t;
+
+#if LED_STRIP_PORT_WIDTH != 8 && LED_STRIP_PORT_WIDTH != 16
+#error "LED_STRIP_PORT_WIDTH must be 8 or 16"
+#endif
+#if LED_STRIP_NUM > LED_STRIP_PORT_WIDTH
+#error "LED_STRIP_NUM must not exceed LED_STRIP_PORT_WIDTH"
+#endif
+#endif
+
+// Engine state. One instance drives the LEDs; with LED_CONTEXT_ENABLE an
+// application can keep more (lite_led_ctx_init()) and pick, per thread,
+// which one the API works on (lite_led_ctx_select()).
+struct led_ctx {
+    led_dev_t list[LED_NUM];
+    uint32_t tick;
+    led_stats_t stats;
+#if LED_SCRIPT_ENABLE
+    led_script_frame_t script_arena[LED_SCRIPT_POOL_SIZE];
+    led_pool_t pool[LED_POOL_MAX];
+#endif
+#if LED_CLOCK_ENABLE
+    led_clock_t clock[LED_CLOCK_MAX];
+    bool clock_ready;
+#endif
+#if LED_SYNC_ENABLE
+    led_time_us_f sync_now_us;
+    int64_t sync_pos_q16;       // Time base (Q16 polls)
+    int64_t sync_carry;         // Trim not applied yet (Q32 polls)
+    int64_t sync_freq_q8;       // Learned rate offset (ppm, Q8)
+    uint32_t sync_poll_us;      // Local time of the last poll
+    uint32_t sync_last_us;      // Local time of the last sync input
+#endif
+#if LED_JOURNAL_ENABLE
+    led_journal_rec_t *journal;     // Caller buffer, NULL = not recording
+    size_t journal_size;
+    size_t journal_len;
+    led_journal_flush_f journal_cb;
+    uint32_t journal_sent[LED_NUM];     // Digest of the levels sent per LED
+#if LED_SCENE_ENABLE
+    led_scene_t journal_scene;          // Scene rebuilt by a replay
+#endif
+#endif
+#if LED_EVENT_ENABLE
+    led_binding_t event_table[LED_EVENT_NUM];
+#endif
+#if LED_CHARLIE_ENABLE
+    led_charlie_slot_t charlie_slot[LED_NUM];
+    uint8_t charlie_slot_of[LED_NUM];   // Slot + 1 per LED, 0 = not charlieplexed
+    size_t charlie_slot_num;
+    led_charlie_state_t charlie_sched[LED_NUM * LED_CHARLIE_LEVELS];
+    size_t charlie_pos;
+#endif
+#if LED_CCT_ENABLE
+    led_cct_t cct[LED_CCT_NUM];
+    uint8_t cct_of[LED_NUM];            // Entity + 1 per LED, 0 = plain LED
+    uint16_t cct_mix[LED_CCT_LUT_SIZE]; // Cold share (Q8) per CCT step
+    bool cct_mix_ready;
+#endif
+#if LED_CALIB_ENABLE
+    uint8_t calib_lut[LED_CALIB_BIN_NUM][256];  // Calibration only
+    uint8_t calib_bin[LED_NUM];
+#endif
+#if LED_OUT_LUT_ENABLE
+    // Output table per bin: any uint8_t brightness in, final percent out
+    uint8_t out_lut[LED_OUT_BIN_NUM][256];
+    uint16_t master_q8;         // Application master level (Q8)
+    uint16_t derate_q8;         // Thermal derating (Q8)
+    bool out_ready;
+#endif
+#if LED_THERMAL_ENABLE
+    int32_t thermal_temp_q8;    // 0.1 degC, Q8
+    bool thermal_sensor;
+#endif
+#if LED_OUTPUT_INTERP_ENABLE
+    led_interp_t interp[LED_NUM];
+#endif
+#if LED_MOD_ENABLE
+    led_lfo_t lfo[LED_LFO_NUM];
+    led_mod_route_t mod_route[LED_MOD_ROUTE_NUM];
+    led_mod_t mod[LED_NUM];
+    bool mod_ready;
+#endif
+#if LED_SCENE_ENABLE
+    const led_scene_t *scene;       // Scene to load at the next poll
+    const led_scene_t *scene_live;  // Scene the LEDs copy their effect from
+    uint32_t scene_gen;             // Bumped by every scene load
+    uint32_t scene_seen[LED_NUM];   // Scene load each LED has caught up with
+    uint32_t morph_total;           // Morph length in polls, 0 = no morph
+    uint32_t morph_tick;
+    uint32_t morph_pending;         // Morph length of the scene to load
+    bool morph_cut;                 // The last load cut a running morph short
+    uint16_t morph_q8;              // Share of the new output (Q8)
+    uint8_t morph_from[LED_NUM];    // Output when the scene was loaded
+    uint8_t morph_level[LED_NUM];   // Last output, after any morph blend
+    bool morph_on[LED_NUM];
+#endif
+#if LED_SCHED_ENABLE
+    const led_sched_entry_t *sched;
+    uint16_t sched_num;
+    uint16_t sched_next;        // First entry not yet run today
+    uint32_t sched_due_ms;      // Time of that entry
+    uint32_t sched_ms;          // Time of day advanced by the poll
+    uint8_t sched_wday;         // 0 = Sunday
+#endif
+#if LED_GOV_ENABLE
+    led_time_us_f gov_now_us;
+    uint32_t gov_start_us;
+    uint32_t gov_cost_q4;       // Average poll cost (us, Q4)
+    uint32_t gov_hold;
+#endif
+#if LED_STRIP_ENABLE
+    led_strip_t strip[LED_STRIP_NUM];
+    led_rgb_t palette[LED_PALETTE_SIZE];            // Base colors
+    uint8_t palette_bind[LED_PALETTE_SIZE];         // LED + 1 scaling the entry, 0 = full
+    uint8_t palette_out[LED_PALETTE_SIZE][3];       // Scaled colors in wire order
+    uint8_t palette_level[LED_NUM];                 // Last level sent to each LED
+    bool palette_bound[LED_NUM];
+#if LED_PARALLEL_ENABLE
+    atomic_bool palette_dirty;      // Set by parallel workers in lite_led_send()
+#else
+    bool palette_dirty;
+#endif
+    uint8_t *port_buf;          // Parallel stream, NULL = strips sent one by one
+    size_t port_size;
+    led_strip_write_f port_cb;
+#endif
+#if LED_PARALLEL_ENABLE
+    atomic_size_t chunk_next;
+    atomic_uint par_updates;
+    atomic_uint par_changes;
+#endif
+#if LED_TIMER_SCAN_ENABLE
+    // Polls each LED sits out before its next edge, kept out of led_dev_t
+    // so the countdown is a single pass over contiguous arrays
+    uint32_t wait[LED_NUM];
+    uint32_t wait_set[LED_NUM];     // Wait the LED was parked with
+    uint8_t due[LED_NUM + 8];       // 1: update the LED in this poll, zero padded
+#if LED_CLOCK_ENABLE
+    uint32_t wait_clock_gen[LED_CLOCK_MAX];     // Domain rates the waits were counted at
+#endif
+#if LED_SCENE_ENABLE
+    uint32_t wait_scene_gen;        // Scene load the waits were counted at
+#endif
+#endif
+};
+
+// Power-on state: zero but for these
+static struct led_ctx g_led_ctx_main = {
+    .stats = {
+        .curve_kernel = LED_BREATH_LUT_ENABLE ? LED_KERNEL_LUT : LED_KERNEL_COS,
+    },
+#if LED_OUT_LUT_ENABLE
+    .master_q8 = 256,
+    .derate_q8 = 256,
+#endif
+#if LED_THERMAL_ENABLE
+    .thermal_temp_q8 = LED_THERMAL_AMBIENT_DC * 256,
+#endif
+#if LED_SCENE_ENABLE
+    .morph_q8 = 256,
+#endif
+#if LED_SCHED_ENABLE
+    .sched_due_ms = LED_DAY_MS,
+#endif
+};
+
+#if LED_CONTEXT_ENABLE
+static _Thread_local struct led_ctx *g_led_ctx = &g_led_ctx_main;   // State the calling thread works on
+#define LED_CTX             (g_led_ctx)
+#else
+#define LED_CTX             (&g_led_ctx_main)
+#endif
+
+#define g_led_list              (LED_CTX->list)
+#define g_led_tick              (LED_CTX->tick)
+#define g_led_stats             (LED_CTX->stats)
+#if LED_SCRIPT_ENABLE
+#define g_led_script_arena      (LED_CTX->script_arena)
+#define g_led_pool              (LED_CTX->pool)
+#endif
+#if LED_CLOCK_ENABLE
+#define g_led_clock             (LED_CTX->clock)
+#define g_led_clock_ready       (LED_CTX->clock_ready)
+#endif
+#if LED_SYNC_ENABLE
+#define g_led_sync_now_us       (LED_CTX->sync_now_us)
+#define g_led_sync_pos_q16      (LED_CTX->sync_pos_q16)
+#define g_led_sync_carry        (LED_CTX->sync_carry)
+#define g_led_sync_freq_q8      (LED_CTX->sync_freq_q8)
+#define g_led_sync_poll_us      (LED_CTX->sync_poll_us)
+#define g_led_sync_last_us      (LED_CTX->sync_last_us)
+#endif
+#if LED_JOURNAL_ENABLE
+#define g_led_journal           (LED_CTX->journal)
+#define g_led_journal_size      (LED_CTX->journal_size)
+#define g_led_journal_len       (LED_CTX->journal_len)
+#define g_led_journal_cb        (LED_CTX->journal_cb)
+#define g_led_journal_sent      (LED_CTX->journal_sent)
+#define g_led_journal_scene     (LED_CTX->journal_scene)
+#endif
+#if LED_EVENT_ENABLE
+#define g_led_event_table       (LED_CTX->event_table)
+#endif
+#if LED_CHARLIE_ENABLE
+#define g_led_charlie_slot      (LED_CTX->charlie_slot)
+#define g_led_charlie_slot_of   (LED_CTX->charlie_slot_of)
+#define g_led_charlie_slot_num  (LED_CTX->charlie_slot_num)
+#define g_led_charlie_sched     (LED_CTX->charlie_sched)
+#define g_led_charlie_pos       (LED_CTX->charlie_pos)
+#endif
+#if LED_CCT_ENABLE
+#define g_led_cct               (LED_CTX->cct)
+#define g_led_cct_of            (LED_CTX->cct_of)
+#define g_led_cct_mix           (LED_CTX->cct_mix)
+#define g_led_cct_mix_ready     (LED_CTX->cct_mix_ready)
+#endif
+#if LED_CALIB_ENABLE
+#define g_led_calib_lut         (LED_CTX->calib_lut)
+#define g_led_calib_bin         (LED_CTX->calib_bin)
+#endif
+#if LED_OUT_LUT_ENABLE
+#define g_led_out_lut           (LED_CTX->out_lut)
+#define g_led_master_q8         (LED_CTX->master_q8)
+#define g_led_derate_q8         (LED_CTX->derate_q8)
+#define g_led_out_ready         (LED_CTX->out_ready)
+#endif
+#if LED_THERMAL_ENABLE
+#define g_led_thermal_temp_q8   (LED_CTX->thermal_temp_q8)
+#define g_led_thermal_sensor    (LED_CTX->thermal_sensor)
+#endif
+#if LED_OUTPUT_INTERP_ENABLE
+#define g_led_interp            (LED_CTX->interp)
+#endif
+#if LED_MOD_ENABLE
+#define g_led_lfo               (LED_CTX->lfo)
+#define g_led_mod_route         (LED_CTX->mod_route)
+#define g_led_mod               (LED_CTX->mod)
+#define g_led_mod_ready         (LED_CTX->mod_ready)
+#endif
+#if LED_SCENE_ENABLE
+#define g_led_scene             (LED_CTX->scene)
+#define g_led_scene_live        (LED_CTX->scene_live)
+#define g_led_scene_gen         (LED_CTX->scene_gen)
+#define g_led_scene_seen        (LED_CTX->scene_seen)
+#define g_led_morph_total       (LED_CTX->morph_total)
+#define g_led_morph_tick        (LED_CTX->morph_tick)
+#define g_led_morph_pending     (LED_CTX->morph_pending)
+#define g_led_morph_cut         (LED_CTX->morph_cut)
+#define g_led_morph_q8          (LED_CTX->morph_q8)
+#define g_led_morph_from        (LED_CTX->morph_from)
+#define g_led_morph_level       (LED_CTX->morph_level)
+#define g_led_morph_on          (LED_CTX->morph_on)
+#endif
+#if LED_SCHED_ENABLE
+#define g_led_sched             (LED_CTX->sched)
+#define g_led_sched_num         (LED_CTX->sched_num)
+#define g_led_sched_next        (LED_CTX->sched_next)
+#define g_led_sched_due_ms      (LED_CTX->sched_due_ms)
+#define g_led_sched_ms          (LED_CTX->sched_ms)
+#define g_led_sched_wday        (LED_CTX->sched_wday)
+#endif
+#if LED_GOV_ENABLE
+#define g_led_gov_now_us        (LED_CTX->gov_now_us)
+#define g_led_gov_start_us      (LED_CTX->gov_start_us)
+#define g_led_gov_cost_q4       (LED_CTX->gov_cost_q4)
+#define g_led_gov_hold          (LED_CTX->gov_hold)
+#endif
+#if LED_STRIP_ENABLE
+#define g_led_strip             (LED_CTX->strip)
+#define g_led_palette           (LED_CTX->palette)
+#define g_led_palette_bind      (LED_CTX->palette_bind)
+#define g_led_palette_out       (LED_CTX->palette_out)
+#define g_led_palette_level     (LED_CTX->palette_level)
+#define g_led_palette_bound     (LED_CTX->palette_bound)
+#define g_led_palette_dirty     (LED_CTX->palette_dirty)
+#define g_led_port_buf          (LED_CTX->port_buf)
+#define g_led_port_size         (LED_CTX->port_size)
+#define g_led_port_cb           (LED_CTX->port_cb)
+#endif
+#if LED_PARALLEL_ENABLE
+#define g_led_chunk_next        (LED_CTX->chunk_next)
+#define g_led_par_updates       (LED_CTX->par_updates)
+#define g_led_par_changes       (LED_CTX->par_changes)
+#endif
+#if LED_TIMER_SCAN_ENABLE
+#define g_led_wait              (LED_CTX->wait)
+#define g_led_wait_set          (LED_CTX->wait_set)
+#define g_led_due               (LED_CTX->due)
+#define g_led_wait_clock_gen    (LED_CTX->wait_clock_gen)
+#define g_led_wait_scene_gen    (LED_CTX->wait_scene_gen)
+#endif
+
+#if LED_SCRIPT_ENABLE
+static const led_pool_def_t g_led_pool_def[LED_POOL_MAX] = {
+    { sizeof(led_script_frame_t), offsetof(struct led_ctx, script_arena), sizeof(g_led_ctx_main.script_arena) },
+};
+#endif
+
+static void lite_led_output(led_dev_t *led);
+static bool lite_led_is_phase_mode(led_mode_e mode);
+#if LED_PULL_ENABLE || LED_PARALLEL_ENABLE
+static bool lite_led_is_follower(const led_dev_t *led);
+#endif
+#if LED_PULL_ENABLE
+static bool lite_led_is_lazy(const led_dev_t *led);
+static uint8_t lite_led_eval(const led_dev_t *led);
+static led_state_e lite_led_eval_state(const led_dev_t *led);
+#endif
+#if LED_CCT_ENABLE
+static bool lite_led_cct_is_slave(const led_dev_t *led);
+#endif
+#if LED_CHARLIE_ENABLE
+static int lite_led_setup(uint8_t id, led_set_brt_f cb);
+#endif
+#if LED_JOURNAL_ENABLE
+static led_journal_rec_t *lite_led_journal_add(led_journal_op_e op, uint8_t id, uint32_t arg);
+static void lite_led_journal_unsupported(led_journal_op_e op, uint8_t id);
+#endif
+
+#if LED_BREATH_LUT_ENABLE || LED_AUTOTUNE_ENABLE
 #define LED_TABLE_SIZE 128
 static const uint8_t g_led_sin_table[LED_TABLE_SIZE + 1] = {
     0,  1,  2,  3,  4,  5,  7,  8, 10, 11, 13, 15, 16, 18, 20, 22,
@@ -57,204 +561,4121 @@ static const uint8_t g_led_sin_table[LED_TABLE_SIZE + 1] = {
    18, 16, 15, 13, 11, 10,  8,  7,  5,  4,  3,  2,  1,  0,  0,  0
 };
 
-static uint8_t lite_led_get_percent_from_phase(float phase)
+/**
+ * @brief Table entry a phase falls on
+ */
+static size_t lite_led_table_index(float phase)
 {
     float step = LED_2PI / LED_TABLE_SIZE;
     size_t index = (size_t)(phase / step);
     if (index > LED_TABLE_SIZE) index = LED_TABLE_SIZE;
 
-    return g_led_sin_table[index];
+    return index;
+}
+
+static uint8_t lite_led_get_percent_from_phase(float phase)
+{
+    return g_led_sin_table[lite_led_table_index(phase)];
 }
 #endif
 
+#if LED_AUTOTUNE_ENABLE
+typedef uint8_t (*led_curve_f)(float phase);
+
+static uint8_t lite_led_curve_cosf(float phase)
+{
+    return (uint8_t)((1.0f - cosf(phase)) * 0.5f * LED_MAX_BRIGHTNESS);
+}
+
+static uint8_t lite_led_curve_cos(float phase)
+{
+    return (uint8_t)((1 - cos(phase)) / 2.0 * LED_MAX_BRIGHTNESS);
+}
+
+// Every other entry of g_led_sin_table
+static const uint8_t g_led_sin_half[LED_TABLE_SIZE / 2 + 1] = {
+    0,  2,  4,  7, 10, 13, 16, 20, 24, 28, 32, 37, 41, 46, 51, 56,
+   61, 67, 72, 77, 83, 88, 94,100,100,100,100,100,100,100,100,100,
+  100,100,100,100,100,100,100,100, 97, 91, 86, 80, 75, 69, 64, 59,
+   54, 49, 44, 39, 34, 30, 26, 22, 18, 15, 11,  8,  5,  3,  1,  0,
+    0
+};
+
 /**
- * @brief Initialize an LED instance
- * 
- * @param id LED ID (0 ~ LED_NUM-1)
- * @param cb Callback for brightness setting (0-100%)
- * @return int Error code (0: success, <0: failure)
+ * @brief Table curve from the half-size table, rounding between entries
  */
-int lite_led_init(uint8_t id, led_set_brt_f cb)
+static uint8_t lite_led_curve_lut_half(float phase)
 {
-    if (id >= LED_NUM || cb == NULL) return -1;
+    size_t index = lite_led_table_index(phase);
+    size_t half = index >> 1;
 
-    memset(&g_led_list[id], 0, sizeof(led_dev_t));
-    g_led_list[id].id = id;
-    g_led_list[id].set_percent_cb = cb;
+    if ((index & 1u) == 0) return g_led_sin_half[half];
 
-    return LED_ERROR_NONE;
+    return (uint8_t)((g_led_sin_half[half] + g_led_sin_half[half + 1] + 1u) >> 1);
 }
 
+#if LED_BREATH_LUT_ENABLE
+// g_led_sin_table rises over entries 0 ~ LED_POLY_TOP, holds 100 up to
+// LED_POLY_FALL and falls back as its mirror image, ending on 0
+#define LED_POLY_TOP        (46)
+#define LED_POLY_FALL       (80)
+
 /**
- * @brief Configure LED behavior
+ * @brief Table curve without the table: a cubic fit of the rising entries
  *
- * @param id LED ID
- * @param cfg LED configuration
- * @return int Error code
+ * Rounded, the cubic gives each rising entry exactly.
  */
-int lite_led_write(uint8_t id, const led_cfg_t *cfg)
+static uint8_t lite_led_curve_poly(float phase)
 {
-    led_dev_t *led = NULL;
+    size_t index = lite_led_table_index(phase);
+    float x;
 
-    if (id >= LED_MAX || cfg == NULL) return LED_ERROR_PARA_INVALID;
+    if (index > LED_POLY_FALL + LED_POLY_TOP - 1) return 0;
+    if (index >= LED_POLY_FALL) {
+        index = LED_POLY_FALL + LED_POLY_TOP - 1 - index;
+    } else if (index > LED_POLY_TOP) {
+        return LED_MAX_BRIGHTNESS;
+    }
+    x = (float)index;
 
-    led = &g_led_list[id];
+    return (uint8_t)(-0.125575f + x * (0.927347f + x * (0.040299f - x * 0.000289f)) + 0.5f);
+}
+#else
+/**
+ * @brief Cosine curve from its Taylor polynomial up to x^10
+ *
+ * The phase is folded into 0 ~ π first, where the truncation error stays
+ * below 0.1% of full brightness.
+ */
+static uint8_t lite_led_curve_poly(float phase)
+{
+    float x2;
 
-    led->cfg.mode = cfg->mode;
-    led->cfg.alter_id = cfg->alter_id;
-    led->cfg.on_tick = cfg->on_ms / LED_POLL_PERIOD_MS;
-    led->cfg.off_tick = cfg->off_ms / LED_POLL_PERIOD_MS;
-    led->cfg.fade_tick = cfg->fade_ms / LED_POLL_PERIOD_MS;
-    led->cfg.alternate_tick = cfg->alternate_ms / LED_POLL_PERIOD_MS;
-    led->cfg.duration_tick = cfg->duration_ms / LED_POLL_PERIOD_MS;
+    if (phase > (float)LED_PI) phase = (float)LED_2PI - phase;
+    if (phase < 0.0f) phase = 0.0f;
+    x2 = phase * phase;
 
-    memset(&(led->stat), 0, sizeof(led->stat));
-    led->stat.remain_tick = led->cfg.duration_tick;
+    // (1 - cos(x)) / 2 = x^2/4 - x^4/48 + x^6/1440 - x^8/80640 + x^10/7257600
+    return (uint8_t)(x2 * (1.0f / 4 - x2 * (1.0f / 48 - x2 * (1.0f / 1440 - x2 * (1.0f / 80640 -
+                     x2 * (1.0f / 7257600))))) * LED_MAX_BRIGHTNESS);
+}
+#endif
 
-    switch (cfg->mode) {
-        case LED_MODE_ON:
-            break;
-        case LED_MODE_OFF:
-            break;
-        case LED_MODE_BLINK:
-            break;
-        case LED_MODE_BREATH:
-        case LED_MODE_FADE_IN:
-        case LED_MODE_FADE_OUT:
-            // Phase step controls brightness update speed
-            led->stat.phase_step = (float)LED_PI * LED_POLL_PERIOD_MS / (float)cfg->fade_ms;
-            if (led->stat.phase_step <= 0.0f) {
-                led->stat.phase_step = (float)LED_PI / (float)LED_MAX_BRIGHTNESS;
-            }
-            if (cfg->mode == LED_MODE_FADE_OUT) {
-                led->stat.percent = LED_MAX_BRIGHTNESS;
-                led->stat.phase = LED_PI;
-                led->stat.phase_step = -led->stat.phase_step;
-            } else {
-                led->stat.percent = LED_MIN_BRIGHTNESS;
-                led->stat.phase = 0.0f;
-            }
-            break;
-        case LED_MODE_ALTERNATE:
-            if (id == cfg->alter_id) return LED_ERROR_ALTERNATE_ID;
-            break;
-        default:
-            return LED_ERROR_MODE_INVALID;
-    }
+// Candidates in led_kernel_e order
+static const led_curve_f g_led_curve_kernels[LED_KERNEL_MAX] = {
+    lite_led_get_percent_from_phase,
+    lite_led_curve_cosf,
+    lite_led_curve_cos,
+    lite_led_curve_lut_half,
+    lite_led_curve_poly,
+};
+// Kernel selected by LED_BREATH_LUT_ENABLE, which the others must match
+#define LED_KERNEL_REF      (LED_BREATH_LUT_ENABLE ? LED_KERNEL_LUT : LED_KERNEL_COS)
+#define LED_KERNEL_TOL      (1)     // Largest brightness difference (%) to the reference
+static led_curve_f g_led_curve_f = LED_BREATH_LUT_ENABLE ? lite_led_get_percent_from_phase : lite_led_curve_cos;
+static led_kernel_e g_led_curve_kernel = LED_KERNEL_REF;   // Shared by all contexts, like g_led_curve_f
+#endif
 
-    return LED_ERROR_NONE;
+/**
+ * @brief Brightness of the cosine curve at a phase (0 ~ 2π)
+ */
+static uint8_t lite_led_curve(float phase)
+{
+    uint8_t percent;
+
+#if LED_AUTOTUNE_ENABLE
+    percent = g_led_curve_f(phase);
+#elif LED_BREATH_LUT_ENABLE
+    percent = lite_led_get_percent_from_phase(phase);
+#else
+    percent = (uint8_t)((1 - cos(phase)) / 2.0 * LED_MAX_BRIGHTNESS);
+#endif
+    if (percent >= LED_MAX_BRIGHTNESS) percent = LED_MAX_BRIGHTNESS;
+
+    return percent;
 }
 
+#if LED_AUTOTUNE_ENABLE
 /**
- * @brief Read LED current status
+ * @brief Check that a kernel draws the same curve as the reference kernel
  *
- * @param id LED ID
- * @param status Output status
- * @return int Error code
+ * Swapping kernels must not change what the LEDs show, so a candidate has
+ * to stay within LED_KERNEL_TOL of LED_KERNEL_REF over the whole cycle.
  */
-int lite_led_read(uint8_t id, led_status_t *status)
+static bool lite_led_kernel_matches(size_t k)
 {
-    if (id >= LED_NUM || status == NULL) return LED_ERROR_PARA_INVALID;
+    uint8_t ref, out;
+    float phase;
 
-    *status = g_led_list[id].stat;
+    for (uint32_t i = 0; i <= LED_TABLE_SIZE * 16u; i++) {
+        phase = (float)LED_2PI * (float)i / (LED_TABLE_SIZE * 16u);
+        ref = g_led_curve_kernels[LED_KERNEL_REF](phase);
+        out = g_led_curve_kernels[k](phase);
+        if (ref > LED_MAX_BRIGHTNESS) ref = LED_MAX_BRIGHTNESS;
+        if (out > LED_MAX_BRIGHTNESS) out = LED_MAX_BRIGHTNESS;
+        if (ref - out > LED_KERNEL_TOL || out - ref > LED_KERNEL_TOL) return false;
+    }
 
-    return LED_ERROR_NONE;
+    return true;
 }
 
 /**
- * @brief Periodic LED state update
+ * @brief Pick the fastest brightness curve kernel for this host
  *
- * This function should be called every LED_POLL_PERIOD_MS.
- * It updates LED states, handles timers, and triggers brightness callbacks.
+ * Only kernels that match the curve chosen by LED_BREATH_LUT_ENABLE take
+ * part, so the result changes speed but not output: with the table, the
+ * full and the half-size table and the table's polynomial; without it,
+ * both cosines and the cosine polynomial. Which one is fastest depends on
+ * the FPU, flash wait states and cache of the target. Each one runs over
+ * a phase sweep for an equal share of the time budget; the one with the
+ * most calls wins and is used from then on. The choice is reported in
+ * led_stats_t.curve_kernel. Intended to run once at startup, before the
+ * first poll.
+ *
+ * @param budget_ms Total calibration time in milliseconds
+ * @return int Error code
  */
-void lite_led_poll_handle(void)
+int lite_led_autotune(uint32_t budget_ms)
 {
-    led_dev_t *led = NULL;
+    clock_t slice = (clock_t)((uint64_t)budget_ms * CLOCKS_PER_SEC / 1000u / LED_KERNEL_MAX);
+    volatile uint32_t sink = 0;
+    uint32_t best_calls = 0;
+    size_t best = LED_KERNEL_REF;
 
-    for (size_t i = 0; i < LED_NUM; i++) {
-        led = &g_led_list[i];
-        if (led->set_percent_cb == NULL) continue;
-
-        // Duration handling
-        if (led->stat.remain_tick != 0) {
-            led->stat.remain_tick--;
-            if (led->stat.remain_tick == 0) {
-                led->cfg.mode = LED_MODE_OFF;
-                led->stat.next_tick = 0;
-                continue;
+    if (slice == 0) return LED_ERROR_PARA_INVALID;
+
+    for (size_t k = 0; k < LED_KERNEL_MAX; k++) {
+        uint32_t calls = 0;
+        uint32_t sum = 0;
+        clock_t start;
+
+        if (!lite_led_kernel_matches(k)) continue;
+
+        start = clock();
+        do {
+            // Batches keep clock() out of the measured work
+            for (uint32_t i = 0; i < LED_TABLE_SIZE; i++) {
+                sum += g_led_curve_kernels[k]((float)LED_2PI * (float)i / LED_TABLE_SIZE);
             }
-        }
+            calls += LED_TABLE_SIZE;
+        } while (clock() - start < slice);
 
-        // Tick countdown
-        if (led->stat.next_tick == LED_BLOCK_FOREVER) continue;
-        if (led->stat.next_tick != 0) {
-            led->stat.next_tick--;
-            if (led->stat.next_tick != 0) continue;
+        sink += sum;
+        if (calls > best_calls) {
+            best_calls = calls;
+            best = k;
         }
+    }
+    (void)sink;
 
-        // Mode handling
-        switch (led->cfg.mode) {
-            case LED_MODE_OFF:
-                led->stat.state = LED_STATE_OFF;
-                led->stat.percent = LED_MIN_BRIGHTNESS;
-                led->stat.next_tick = LED_BLOCK_FOREVER;
-                break;
-            case LED_MODE_ON:
-                led->stat.state = LED_STATE_ON;
-                led->stat.percent = LED_MAX_BRIGHTNESS;
-                led->stat.next_tick = LED_BLOCK_FOREVER;
-                break;
-            case LED_MODE_BLINK:
-                if (led->stat.state == LED_STATE_OFF) {
-                    led->stat.next_tick = led->cfg.on_tick;
-                    led->stat.percent = LED_MAX_BRIGHTNESS;
-                } else {
-                    led->stat.next_tick = led->cfg.off_tick;
-                    led->stat.percent = LED_MIN_BRIGHTNESS;
-                }
-                led->stat.state = !(led->stat.state);
-                break;
-            case LED_MODE_FADE_IN:
-            case LED_MODE_FADE_OUT:
-            case LED_MODE_BREATH:
-                led->stat.phase += led->stat.phase_step; // Phase update
-                if (led->cfg.mode == LED_MODE_BREATH) {
-                    if (led->stat.phase >= LED_2PI) led->stat.phase -= LED_2PI;
-                } else if (led->cfg.mode == LED_MODE_FADE_IN) {
-                    if (led->stat.phase >= LED_PI) {
-                        led->stat.phase = LED_PI;
-                        led->stat.next_tick = LED_BLOCK_FOREVER;
-                    }
-                } else if (led->cfg.mode == LED_MODE_FADE_OUT) {
-                    if (led->stat.phase <= 0.0f) {
-                        led->stat.phase = 0.0f;
-                        led->stat.next_tick = LED_BLOCK_FOREVER;
-                    }
-                }
-                // Brightness update (cosine wave)
-#if LED_BREATH_LUT_ENABLE
-                led->stat.percent = lite_led_get_percent_from_phase(led->stat.phase);
-#else
-                led->stat.percent = (uint8_t)((1 - cos(led->stat.phase)) / 2.0 * LED_MAX_BRIGHTNESS);
+    g_led_curve_f = g_led_curve_kernels[best];
+    g_led_curve_kernel = (led_kernel_e)best;
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_KERNEL, 0, (uint32_t)best);
 #endif
-                if (led->stat.percent >= LED_MAX_BRIGHTNESS) led->stat.percent = LED_MAX_BRIGHTNESS;
-                break;
-            case LED_MODE_ALTERNATE:
-                if (led->cfg.alter_id >= LED_NUM) break;
-                led->stat.next_tick = led->cfg.alternate_tick;
-                if (led->id < led->cfg.alter_id) {
-                    led->stat.state = !(led->stat.state);
-                    led->stat.percent = (led->stat.state == LED_STATE_ON) ? LED_MAX_BRIGHTNESS : LED_MIN_BRIGHTNESS;
-                } else {
-                    led->stat.state = !(g_led_list[led->cfg.alter_id].stat.state);
-                    led->stat.percent = (led->stat.state == LED_STATE_ON) ? LED_MAX_BRIGHTNESS : LED_MIN_BRIGHTNESS;
-                }
-                break;
-            default:
-                break;
-        }
 
-        // Update brightness
-        led->set_percent_cb(led->stat.percent);
+    return LED_ERROR_NONE;
+}
+#endif
+
+#if LED_JOURNAL_ENABLE
+/**
+ * @brief Append a record stamped with the current tick
+ *
+ * A full buffer goes to the flush callback; without one, records are
+ * dropped and counted.
+ *
+ * @return led_journal_rec_t* Record to fill in, NULL if not recorded
+ */
+static led_journal_rec_t *lite_led_journal_add(led_journal_op_e op, uint8_t id, uint32_t arg)
+{
+    led_journal_rec_t *rec;
+
+    if (g_led_journal == NULL) return NULL;
+    if (g_led_journal_len == g_led_journal_size) {
+        if (g_led_journal_cb == NULL) {
+            g_led_stats.journal_dropped++;
+            return NULL;
+        }
+        g_led_journal_cb(g_led_journal, g_led_journal_len);
+        g_led_journal_len = 0;
     }
+
+    rec = &g_led_journal[g_led_journal_len++];
+    memset(rec, 0, sizeof(*rec));
+    rec->tick = g_led_tick;
+    rec->op = (uint8_t)op;
+    rec->id = id;
+    rec->arg[0] = arg;
+
+    return rec;
+}
+
+/**
+ * @brief Log a call that a replay cannot make
+ *
+ * The record keeps the call's place in the journal; applying it fails, and
+ * lite_led_journal_stop() reports the recording as not replayable.
+ */
+static void lite_led_journal_unsupported(led_journal_op_e op, uint8_t id)
+{
+    if (g_led_journal == NULL) return;
+
+    g_led_stats.journal_unsupported++;
+    lite_led_journal_add(LED_JOURNAL_UNSUPPORTED, id, op);
 }
+
+/**
+ * @brief Digest of the levels sent to the backends, all LEDs folded in order
+ */
+static uint32_t lite_led_journal_digest(void)
+{
+    uint32_t digest = LED_JOURNAL_FNV_BASIS;
+
+    for (size_t i = 0; i < LED_NUM; i++) {
+        digest = (digest ^ g_led_journal_sent[i]) * LED_JOURNAL_FNV_PRIME;
+    }
+
+    return digest;
+}
+
+/**
+ * @brief Start recording API calls
+ *
+ * The LEDs initialized so far are logged as INIT records; start right
+ * after lite_led_init() so that a replay from the first poll goes through
+ * the same states. Calls that hand over buffers, pointers or host time
+ * (scripts, tracks, strips, calibration, sync and governor timers) are
+ * logged as UNSUPPORTED. The levels sent to the backends from here on are
+ * digested per LED, so a replay can prove it sent the same ones.
+ *
+ * @param buf Record buffer
+ * @param count Buffer size in records
+ * @param cb Called with the records whenever the buffer is full (may be NULL)
+ * @return int Error code
+ */
+int lite_led_journal_start(led_journal_rec_t *buf, size_t count, led_journal_flush_f cb)
+{
+    if (buf == NULL || count == 0) return LED_ERROR_PARA_INVALID;
+
+    g_led_journal = buf;
+    g_led_journal_size = count;
+    g_led_journal_len = 0;
+    g_led_journal_cb = cb;
+    g_led_stats.journal_dropped = 0;
+    g_led_stats.journal_unsupported = 0;
+    memset(g_led_journal_sent, 0, sizeof(g_led_journal_sent));
+
+    for (uint8_t id = 0; id < LED_NUM; id++) {
+        if (g_led_list[id].set_percent_cb != NULL) lite_led_journal_add(LED_JOURNAL_INIT, id, 0);
+    }
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Stop recording
+ *
+ * Appends an END record with the current tick and the digest of the levels
+ * sent, then hands the buffer to the flush callback if there is one.
+ *
+ * @param count Records left in the buffer, 0 once flushed (may be NULL)
+ * @return int Error code, LED_ERROR_NOT_REPLAYABLE if UNSUPPORTED calls
+ *             were logged (the journal is still complete)
+ */
+int lite_led_journal_stop(size_t *count)
+{
+    if (g_led_journal == NULL) return LED_ERROR_PARA_INVALID;
+
+    lite_led_journal_add(LED_JOURNAL_END, 0, lite_led_journal_digest());
+    if (g_led_journal_cb != NULL && g_led_journal_len != 0) {
+        g_led_journal_cb(g_led_journal, g_led_journal_len);
+        g_led_journal_len = 0;
+    }
+    if (count != NULL) *count = g_led_journal_len;
+    g_led_journal = NULL;
+
+    return (g_led_stats.journal_unsupported != 0) ? LED_ERROR_NOT_REPLAYABLE : LED_ERROR_NONE;
+}
+
+/**
+ * @brief Make the call a record was logged for
+ *
+ * Apply all records of a tick before the poll of that tick to reproduce
+ * the recording.
+ *
+ * @param rec Record
+ * @param cb Brightness callback for the LEDs INIT records set up
+ * @return int Error code of the call, LED_ERROR_NOT_REPLAYABLE for an
+ *             UNSUPPORTED record
+ */
+int lite_led_journal_apply(const led_journal_rec_t *rec, led_set_brt_f cb)
+{
+    led_cfg_t cfg;
+#if LED_SCENE_ENABLE
+    led_inner_cfg_t *entry;
+#endif
+#if LED_STRIP_ENABLE
+    led_rgb_t color;
+#endif
+
+    if (rec == NULL) return LED_ERROR_PARA_INVALID;
+
+    switch (rec->op) {
+        case LED_JOURNAL_WRITE:
+            memset(&cfg, 0, sizeof(cfg));
+            cfg.mode = (led_mode_e)rec->mode;
+            cfg.alter_id = (led_id_e)rec->alter_id;
+            cfg.on_ms = rec->arg[0];
+            cfg.off_ms = rec->arg[1];
+            cfg.fade_ms = rec->arg[2];
+            cfg.alternate_ms = rec->arg[3];
+            cfg.duration_ms = rec->arg[4];
+            cfg.offset_ms = rec->arg[5];
+            return lite_led_write(rec->id, &cfg);
+#if LED_MASTER_ENABLE
+        case LED_JOURNAL_MASTER:
+            return lite_led_set_master((uint8_t)rec->arg[0]);
+#endif
+#if LED_CLOCK_ENABLE
+        case LED_JOURNAL_CLOCK_SPEED:
+            return lite_led_clock_set_speed((led_clock_e)rec->id, rec->arg[0]);
+        case LED_JOURNAL_CLOCK_ATTACH:
+            return lite_led_clock_attach(rec->id, (led_clock_e)rec->arg[0]);
+#endif
+        case LED_JOURNAL_INIT:
+            return lite_led_init(rec->id, cb);
+#if LED_PULL_ENABLE
+        case LED_JOURNAL_PULL:
+            return lite_led_set_pull(rec->id, rec->arg[0] != 0);
+#endif
+#if LED_GOV_ENABLE
+        case LED_JOURNAL_PRIORITY:
+            return lite_led_set_priority(rec->id, rec->arg[0] != 0);
+#endif
+#if LED_AUTOTUNE_ENABLE
+        case LED_JOURNAL_KERNEL:
+            // A kernel that draws another curve than this build's would not replay
+            if (rec->arg[0] >= LED_KERNEL_MAX || !lite_led_kernel_matches(rec->arg[0])) {
+                return LED_ERROR_PARA_INVALID;
+            }
+            g_led_curve_f = g_led_curve_kernels[rec->arg[0]];
+            g_led_curve_kernel = (led_kernel_e)rec->arg[0];
+            return LED_ERROR_NONE;
+#endif
+#if LED_MOD_ENABLE
+        case LED_JOURNAL_LFO:
+            return lite_led_lfo_set(rec->id, (led_lfo_shape_e)rec->arg[0], rec->arg[1]);
+        case LED_JOURNAL_MOD_ROUTE:
+            return lite_led_mod_route(rec->id, (uint8_t)rec->arg[0], (uint8_t)rec->arg[1],
+                                      (led_mod_dest_e)rec->arg[2], (uint8_t)rec->arg[3]);
+#endif
+#if LED_CCT_ENABLE
+        case LED_JOURNAL_CCT_INIT:
+            return lite_led_cct_init(rec->id, (uint8_t)rec->arg[0], (uint8_t)rec->arg[1]);
+        case LED_JOURNAL_CCT_WRITE:
+            return lite_led_cct_write(rec->id, (uint16_t)rec->arg[0], rec->arg[1]);
+#endif
+#if LED_THERMAL_ENABLE
+        case LED_JOURNAL_THERMAL:
+            return lite_led_thermal_set_temp((int16_t)(int32_t)rec->arg[0]);
+#endif
+#if LED_CHARLIE_ENABLE
+        case LED_JOURNAL_CHARLIE_ATTACH:
+            return lite_led_charlie_attach(rec->id, (uint8_t)rec->arg[0], (uint8_t)rec->arg[1]);
+#endif
+#if LED_STRIP_ENABLE
+        case LED_JOURNAL_PALETTE_SET:
+            color.r = (uint8_t)rec->arg[0];
+            color.g = (uint8_t)rec->arg[1];
+            color.b = (uint8_t)rec->arg[2];
+            return lite_led_palette_set(rec->id, color);
+        case LED_JOURNAL_PALETTE_BIND:
+            return lite_led_palette_bind(rec->id, (uint8_t)rec->arg[0]);
+        case LED_JOURNAL_STRIP_TRUNCATE:
+            return lite_led_strip_truncate(rec->id, rec->arg[0] != 0);
+#endif
+#if LED_SCENE_ENABLE
+        case LED_JOURNAL_SCENE_RECALL:
+            // Recalling only stores the pointer: the entries that follow
+            // are in place before the LEDs load them at the next poll
+            memset(g_led_journal_scene.used, 0, sizeof(g_led_journal_scene.used));
+            return lite_led_scene_recall(&g_led_journal_scene, rec->arg[0]);
+        case LED_JOURNAL_SCENE_LED:
+            if (rec->id >= LED_NUM || rec->mode > LED_MODE_ALTERNATE) return LED_ERROR_PARA_INVALID;
+            entry = &g_led_journal_scene.cfg[rec->id];
+            memset(entry, 0, sizeof(*entry));
+            entry->mode = (led_mode_e)rec->mode;
+            entry->alter_id = (led_id_e)rec->alter_id;
+            entry->on_tick = rec->arg[0];
+            entry->off_tick = rec->arg[1];
+            entry->fade_tick = rec->arg[2];
+            entry->alternate_tick = rec->arg[3];
+            entry->duration_tick = rec->arg[4];
+            memcpy(&entry->phase_step, &rec->arg[5], sizeof(entry->phase_step));
+            g_led_journal_scene.used[rec->id] = true;
+            return LED_ERROR_NONE;
+#endif
+#if LED_SCHED_ENABLE
+        case LED_JOURNAL_SCHED_LOAD:
+        case LED_JOURNAL_SCHED_TIME:
+            // Reference only
+            return LED_ERROR_NONE;
+#endif
+        case LED_JOURNAL_UNSUPPORTED:
+            return LED_ERROR_NOT_REPLAYABLE;
+        case LED_JOURNAL_END:
+            return LED_ERROR_NONE;
+        default:
+            return LED_ERROR_PARA_INVALID;
+    }
+}
+#endif
+
+#if LED_TIMER_SCAN_ENABLE
+/**
+ * @brief Count the polls a parked LED sat out against its timers
+ *
+ * The LED is parked short of its next edge and of its duration end, so
+ * the skipped polls did nothing but count both down.
+ */
+static void lite_led_timer_sync(uint8_t id)
+{
+    led_dev_t *led = &g_led_list[id];
+    uint32_t skipped = g_led_wait_set[id] - g_led_wait[id];
+
+    if (skipped == 0) return;
+    if (led->stat.next_tick != LED_BLOCK_FOREVER) led->stat.next_tick -= skipped;
+    if (led->stat.remain_tick != 0) led->stat.remain_tick -= skipped;
+#if LED_GOV_ENABLE
+    led->gov_tick += skipped;
+#if LED_CLOCK_ENABLE
+    // Parked LEDs are on real-time domains: one tick per poll
+    led->gov_time_q16 += (uint64_t)skipped << 16;
+#endif
+#endif
+    g_led_wait_set[id] = g_led_wait[id];
+}
+
+/**
+ * @brief Bring a parked LED up to date and update it from the next poll on
+ *
+ * Called whenever something its parking was decided on changes.
+ */
+static void lite_led_timer_wake(uint8_t id)
+{
+    lite_led_timer_sync(id);
+    g_led_wait[id] = 0;
+    g_led_wait_set[id] = 0;
+}
+#endif
+
+#if LED_SCRIPT_ENABLE
+/**
+ * @brief Thread an arena into a pool's free list
+ */
+static void lite_led_pool_format(led_pool_t *pool, uint8_t *arena, size_t stride, uint16_t capacity)
+{
+    void *next = NULL;
+
+    // Built back to front so objects are handed out in address order
+    for (size_t i = capacity; i != 0; i--) {
+        memcpy(&arena[(i - 1) * stride], &next, sizeof(next));
+        next = &arena[(i - 1) * stride];
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->base = arena;
+    pool->free = next;
+    pool->stride = stride;
+    pool->stats.capacity = capacity;
+}
+
+/**
+ * @brief Size of one object of a pool, to size its arena
+ *
+ * @param pool Pool
+ * @return size_t Bytes per object including alignment, 0 for an invalid pool
+ */
+size_t lite_led_pool_obj_size(led_pool_e pool)
+{
+    if (pool >= LED_POOL_MAX) return 0;
+
+    return (g_led_pool_def[pool].obj_size + LED_POOL_ALIGN - 1) / LED_POOL_ALIGN * LED_POOL_ALIGN;
+}
+
+/**
+ * @brief Place a pool in a caller arena
+ *
+ * The pool holds size / lite_led_pool_obj_size() objects. Call at init,
+ * before the pool's objects are in use; without it the built-in arena is
+ * used. Allocation and release are O(1) and never call malloc.
+ *
+ * @param pool Pool
+ * @param arena Memory aligned to a pointer, must stay valid
+ * @param size Arena size in bytes
+ * @return int Error code
+ */
+int lite_led_pool_setup(led_pool_e pool, void *arena, size_t size)
+{
+    size_t stride = lite_led_pool_obj_size(pool);
+    size_t capacity;
+
+    if (stride == 0 || arena == NULL || ((uintptr_t)arena % LED_POOL_ALIGN) != 0) return LED_ERROR_PARA_INVALID;
+    if (g_led_pool[pool].stats.used != 0) return LED_ERROR_PARA_INVALID;
+
+    capacity = size / stride;
+    if (capacity == 0) return LED_ERROR_NO_MEMORY;
+    if (capacity > UINT16_MAX) capacity = UINT16_MAX;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_unsupported(LED_JOURNAL_POOL_SETUP, (uint8_t)pool);
+#endif
+    lite_led_pool_format(&g_led_pool[pool], (uint8_t *)arena, stride, (uint16_t)capacity);
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Read a pool's usage counters
+ *
+ * @param pool Pool
+ * @param stats Output counters
+ * @return int Error code
+ */
+int lite_led_pool_get_stats(led_pool_e pool, led_pool_stats_t *stats)
+{
+    if (pool >= LED_POOL_MAX || stats == NULL) return LED_ERROR_PARA_INVALID;
+
+    *stats = g_led_pool[pool].stats;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Take an object from a pool
+ *
+ * @return void* Object, NULL if the pool is exhausted
+ */
+static void *lite_led_pool_alloc(led_pool_e id)
+{
+    led_pool_t *pool = &g_led_pool[id];
+    size_t stride;
+    void *obj;
+
+    if (pool->base == NULL) {
+        stride = lite_led_pool_obj_size(id);
+        lite_led_pool_format(pool, (uint8_t *)LED_CTX + g_led_pool_def[id].arena_ofs, stride,
+                             (uint16_t)(g_led_pool_def[id].arena_size / stride));
+    }
+
+    obj = pool->free;
+    if (obj == NULL) {
+        pool->stats.fail_count++;
+        return NULL;
+    }
+    memcpy(&pool->free, obj, sizeof(pool->free));
+
+    pool->stats.used++;
+    if (pool->stats.used > pool->stats.high_water) pool->stats.high_water = pool->stats.used;
+
+    return obj;
+}
+
+/**
+ * @brief Return an object to its pool
+ */
+static void lite_led_pool_free(led_pool_e id, void *obj)
+{
+    led_pool_t *pool = &g_led_pool[id];
+
+    memcpy(obj, &pool->free, sizeof(pool->free));
+    pool->free = obj;
+    pool->stats.used--;
+}
+
+#if LED_PARALLEL_ENABLE
+static atomic_flag g_led_script_lock = ATOMIC_FLAG_INIT;    // Guards the script pool
+#endif
+
+/**
+ * @brief Take a script frame from the pool
+ *
+ * @return led_script_frame_t* Frame, NULL if the pool is exhausted
+ */
+static led_script_frame_t *lite_led_script_alloc(void)
+{
+    led_script_frame_t *frame;
+
+#if LED_PARALLEL_ENABLE
+    while (atomic_flag_test_and_set_explicit(&g_led_script_lock, memory_order_acquire)) {
+    }
+#endif
+    frame = (led_script_frame_t *)lite_led_pool_alloc(LED_POOL_SCRIPT);
+#if LED_PARALLEL_ENABLE
+    atomic_flag_clear_explicit(&g_led_script_lock, memory_order_release);
+#endif
+
+    return frame;
+}
+
+/**
+ * @brief Return the LED's script frame to the pool
+ *
+ * Scene loads take and return frames on the parallel poll workers, so the
+ * free list is guarded by a spin lock there.
+ */
+static void lite_led_script_release(led_dev_t *led)
+{
+    if (led->frame == NULL) return;
+
+#if LED_PARALLEL_ENABLE
+    while (atomic_flag_test_and_set_explicit(&g_led_script_lock, memory_order_acquire)) {
+    }
+#endif
+    lite_led_pool_free(LED_POOL_SCRIPT, led->frame);
+#if LED_PARALLEL_ENABLE
+    atomic_flag_clear_explicit(&g_led_script_lock, memory_order_release);
+#endif
+    led->frame = NULL;
+}
+
+/**
+ * @brief Advance an active ramp by one tick
+ *
+ * @return bool true if the ramp reached its target
+ */
+static bool lite_led_script_ramp(led_dev_t *led, led_script_frame_t *frame)
+{
+    frame->level_q8 += frame->ramp_step_q8;
+    frame->ramp_tick--;
+    if (frame->ramp_tick == 0) {
+        // Land exactly on the target, whatever the rounding
+        frame->level_q8 = (int32_t)frame->script->steps[frame->step - 1].percent << 8;
+    }
+    led->stat.percent = (uint8_t)(frame->level_q8 >> 8);
+    led->stat.next_tick = 0;
+
+    return frame->ramp_tick == 0;
+}
+
+/**
+ * @brief Run script steps until one of them has to wait
+ *
+ * A HOLD parks the LED on next_tick, so a waiting script costs one
+ * countdown per tick. Ramps run every tick until done.
+ */
+static void lite_led_script_run(led_dev_t *led)
+{
+    led_script_frame_t *frame = led->frame;
+    const led_step_t *step;
+    size_t ticks;
+
+    if (frame == NULL) {
+        led->stat.next_tick = LED_BLOCK_FOREVER;
+        return;
+    }
+
+    if (frame->ramp_tick != 0) {
+        if (!lite_led_script_ramp(led, frame)) return;
+    }
+
+    // Bounded so that a script without waits cannot stall the poll
+    for (size_t budget = frame->script->count + 1u; budget != 0; budget--) {
+        if (frame->step >= frame->script->count) {
+            led->stat.next_tick = LED_BLOCK_FOREVER;
+            return;
+        }
+
+        step = &frame->script->steps[frame->step++];
+        switch (step->op) {
+            case LED_STEP_SET:
+                led->stat.percent = step->percent;
+                break;
+            case LED_STEP_RAMP:
+                ticks = step->ms / LED_POLL_PERIOD_MS;
+                if (ticks == 0) {
+                    led->stat.percent = step->percent;
+                    break;
+                }
+                frame->level_q8 = (int32_t)led->stat.percent << 8;
+                frame->ramp_step_q8 = (((int32_t)step->percent << 8) - frame->level_q8) / (int32_t)ticks;
+                frame->ramp_tick = ticks;
+                if (!lite_led_script_ramp(led, frame)) return;
+                break;
+            case LED_STEP_HOLD:
+                ticks = step->ms / LED_POLL_PERIOD_MS;
+                if (ticks == 0) break;
+                led->stat.next_tick = ticks;
+                return;
+            case LED_STEP_LOOP:
+                frame->runs++;
+                if (step->ms == 0 || frame->runs < step->ms) frame->step = 0;
+                break;
+            default:
+                break;
+        }
+    }
+
+    led->stat.next_tick = 0;
+}
+#endif
+
+#if LED_TRACK_ENABLE
+/**
+ * @brief Sample a keyframe track
+ *
+ * The cursor remembers the key found by the previous call, so sampling
+ * with increasing times only steps forward over the keys that were passed.
+ * Going back in time (or wrapping a loop) restarts the search at key 0.
+ *
+ * @param track Keyframe track
+ * @param cursor In/out key cursor, 0 for a fresh start
+ * @param ms Time from track start
+ * @return uint8_t Brightness percent
+ */
+uint8_t lite_led_track_sample(const led_track_t *track, uint16_t *cursor, uint32_t ms)
+{
+    const led_keyframe_t *a;
+    const led_keyframe_t *b;
+    uint32_t length;
+    int32_t u;
+
+    if (track == NULL || track->keys == NULL || track->count == 0) return LED_MIN_BRIGHTNESS;
+
+    length = track->keys[track->count - 1].ms;
+    if (track->loop && length != 0) ms %= length;
+
+    if (*cursor >= track->count || track->keys[*cursor].ms > ms) *cursor = 0;
+    while (*cursor + 1u < track->count && track->keys[*cursor + 1u].ms <= ms) (*cursor)++;
+
+    a = &track->keys[*cursor];
+    if (*cursor + 1u >= track->count || ms <= a->ms) return a->percent;
+    b = a + 1;
+
+    // Position between the two keys (Q8)
+    u = (int32_t)(((uint64_t)(ms - a->ms) << 8) / (b->ms - a->ms));
+    switch (a->interp) {
+        case LED_INTERP_LINEAR:
+            break;
+        case LED_INTERP_EASE:
+            u = (u * u * (3 * 256 - 2 * u)) >> 16;
+            break;
+        default:
+            return a->percent;
+    }
+
+    return (uint8_t)(a->percent + ((((int32_t)b->percent - a->percent) * u) >> 8));
+}
+
+/**
+ * @brief Sample one track for many LEDs at different offsets
+ *
+ * @param track Keyframe track
+ * @param ms Common time from track start
+ * @param offset_ms Per-LED offset added to ms
+ * @param cursor Per-LED key cursors, kept between calls
+ * @param out Per-LED brightness percent
+ * @param n Number of LEDs
+ */
+void lite_led_track_eval(const led_track_t *track, uint32_t ms, const uint32_t *offset_ms,
+                         uint16_t *cursor, uint8_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = lite_led_track_sample(track, &cursor[i], ms + offset_ms[i]);
+    }
+}
+#endif
+
+#if LED_SYNC_ENABLE
+/**
+ * @brief Set the local time source that sync inputs are stamped with
+ *
+ * Polls are stamped with it as well, so an input arriving between two
+ * polls is placed exactly.
+ *
+ * @param now_us Free-running microsecond counter
+ * @return int Error code
+ */
+int lite_led_sync_set_timer(led_time_us_f now_us)
+{
+    if (now_us == NULL) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_unsupported(LED_JOURNAL_SYNC, 0);
+#endif
+    g_led_sync_now_us = now_us;
+    g_led_sync_poll_us = now_us();
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Time base at a local instant (us)
+ */
+static int64_t lite_led_sync_time_us(uint32_t stamp_us)
+{
+    int64_t since_poll = (int32_t)(stamp_us - g_led_sync_poll_us);
+    int64_t polls = g_led_sync_pos_q16 / 65536;
+
+    return polls * LED_SYNC_POLL_US + (g_led_sync_pos_q16 - polls * 65536) * LED_SYNC_POLL_US / 65536 +
+           since_poll + since_poll * g_led_stats.sync_ppm / 1000000;
+}
+
+/**
+ * @brief Limit a value to +-limit
+ */
+static int64_t lite_led_sync_clamp(int64_t value, int64_t limit)
+{
+    if (value > limit) return limit;
+    if (value < -limit) return -limit;
+    return value;
+}
+
+/**
+ * @brief Run the phase-locked loop on one sync input
+ *
+ * The phase error is turned into the rate offset that caused it since
+ * the previous input. A PI filter of that offset sets the trim, so the
+ * time base slews towards the source and learns the local drift. Only
+ * the first input and errors beyond LED_SYNC_STEP_MS move the time base
+ * at once; effects are timed by the clock domains and do not jump.
+ *
+ * @param stamp_us Local time of the input
+ * @param source_us Source time at that instant, modulo span_us
+ * @param span_us Range of source times the input can tell apart
+ */
+static void lite_led_sync_input(uint32_t stamp_us, int64_t source_us, int64_t span_us)
+{
+    int64_t error = (lite_led_sync_time_us(stamp_us) - source_us) % span_us;
+    int64_t interval = (int32_t)(stamp_us - g_led_sync_last_us);
+    int64_t offset;
+
+    // Nearest source instant: pulses are only known modulo the period
+    if (error < 0) error += span_us;
+    if (error >= span_us / 2) error -= span_us;
+
+    g_led_sync_last_us = stamp_us;
+    g_led_stats.sync_error_us = (int32_t)lite_led_sync_clamp(error, INT32_MAX);
+
+    if (!g_led_stats.sync_locked || interval <= 0 ||
+        error > (int64_t)LED_SYNC_STEP_MS * 1000 || error < -(int64_t)LED_SYNC_STEP_MS * 1000) {
+        g_led_sync_pos_q16 -= error * 65536 / LED_SYNC_POLL_US;
+        if (!g_led_stats.sync_locked) {
+            g_led_stats.sync_locked = true;
+#if LED_TIMER_SCAN_ENABLE
+            for (uint8_t id = 0; id < LED_NUM; id++) {
+                lite_led_timer_wake(id);
+            }
+#endif
+        }
+        return;
+    }
+
+    offset = error * 1000000 / interval;
+    g_led_sync_freq_q8 = lite_led_sync_clamp(g_led_sync_freq_q8 - offset * 256 / LED_SYNC_KI_DIV,
+                                             (int64_t)LED_SYNC_MAX_PPM * 256);
+    g_led_stats.sync_ppm = (int32_t)lite_led_sync_clamp(g_led_sync_freq_q8 / 256 - offset / LED_SYNC_KP_DIV,
+                                                        LED_SYNC_MAX_PPM);
+}
+
+/**
+ * @brief Feed a sync pulse
+ *
+ * The source pulses every LED_SYNC_PERIOD_MS and the time base locks to
+ * their phase. Feed every edge read from a GPIO line, eventfd or pipe,
+ * stamped as close to the edge as possible (e.g. the kernel event time).
+ *
+ * @param stamp_us Local time of the edge, from the sync timer
+ * @return int Error code
+ */
+int lite_led_sync_pulse(uint32_t stamp_us)
+{
+    if (g_led_sync_now_us == NULL) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_unsupported(LED_JOURNAL_SYNC, 0);
+#endif
+    lite_led_sync_input(stamp_us, 0, (int64_t)LED_SYNC_PERIOD_MS * 1000);
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Feed a source timestamp
+ *
+ * For sources that broadcast their time, e.g. over the network. The time
+ * base locks to the source time itself, not only to a pulse phase.
+ *
+ * @param source_ms Source time (ms, may wrap)
+ * @param stamp_us Local time the timestamp was valid at, from the sync timer
+ * @return int Error code
+ */
+int lite_led_sync_stamp(uint32_t source_ms, uint32_t stamp_us)
+{
+    if (g_led_sync_now_us == NULL) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_unsupported(LED_JOURNAL_SYNC, 0);
+#endif
+    lite_led_sync_input(stamp_us, (int64_t)source_ms * 1000, (int64_t)1000 << 32);
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Advance the time base by one poll
+ *
+ * @return int32_t Trim of this poll (Q16 polls); the part below one LSB is
+ *         carried, so the average rate is exact
+ */
+static int32_t lite_led_sync_advance(void)
+{
+    int32_t trim;
+
+    if (g_led_sync_now_us != NULL) g_led_sync_poll_us = g_led_sync_now_us();
+
+    g_led_sync_carry += (int64_t)g_led_stats.sync_ppm * 4294967296 / 1000000;
+    trim = (int32_t)(g_led_sync_carry / 65536);
+    g_led_sync_carry -= (int64_t)trim * 65536;
+    g_led_sync_pos_q16 += 65536 + trim;
+
+    return trim;
+}
+#endif
+
+#if LED_CLOCK_ENABLE
+/**
+ * @brief Set every domain to real time on first use
+ */
+static void lite_led_clock_prepare(void)
+{
+    if (g_led_clock_ready) return;
+
+    for (size_t i = 0; i < LED_CLOCK_MAX; i++) {
+        g_led_clock[i].rate_q16 = 1u << 16;
+        g_led_clock[i].scale = 1.0f;
+    }
+    g_led_clock_ready = true;
+}
+
+/**
+ * @brief Advance all clock domains by one poll
+ *
+ * Whole ticks go to `steps`, the fraction is carried, so a domain running
+ * at 1.5x yields 1, 2, 1, 2, ... ticks and never drifts.
+ */
+static void lite_led_clock_advance(void)
+{
+    uint32_t rate;
+#if LED_SYNC_ENABLE
+    int32_t trim = lite_led_sync_advance();
+#endif
+
+    lite_led_clock_prepare();
+
+    for (size_t i = 0; i < LED_CLOCK_MAX; i++) {
+        rate = g_led_clock[i].rate_q16;
+#if LED_SYNC_ENABLE
+        // Every domain follows the time base locked to the sync source
+        rate = (uint32_t)((int64_t)rate * (65536 + trim) / 65536);
+        g_led_clock[i].scale = (float)rate / 65536.0f;
+#endif
+        g_led_clock[i].base_q16 = g_led_clock[i].time_q16;
+        g_led_clock[i].tick = g_led_tick;
+        g_led_clock[i].time_q16 += rate;
+        g_led_clock[i].acc_q16 += rate;
+        g_led_clock[i].steps = g_led_clock[i].acc_q16 >> 16;
+        g_led_clock[i].acc_q16 &= 0xFFFF;
+        if (g_led_clock[i].steps != 0) g_led_clock[i].step_q16 = g_led_clock[i].time_q16 - rate;
+    }
+}
+
+#if LED_GOV_ENABLE
+/**
+ * @brief Time of a clock domain at the end of the last finished poll (Q16 ticks)
+ */
+static uint64_t lite_led_clock_base_q16(led_clock_e clk)
+{
+    // Inside a poll the domain has already been advanced for it
+    return (g_led_clock[clk].tick == g_led_tick) ? g_led_clock[clk].base_q16 : g_led_clock[clk].time_q16;
+}
+#endif
+
+/**
+ * @brief Attach an LED to a clock domain
+ *
+ * The LED's effect timing (ticks, phase, duration) then runs at the
+ * domain's rate. Can be called at any time without restarting the effect.
+ *
+ * @param id LED ID
+ * @param clk Clock domain
+ * @return int Error code
+ */
+int lite_led_clock_attach(uint8_t id, led_clock_e clk)
+{
+    if (id >= LED_NUM || clk >= LED_CLOCK_MAX) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_CLOCK_ATTACH, id, clk);
+#endif
+#if LED_TIMER_SCAN_ENABLE
+    lite_led_timer_wake(id);
+#endif
+#if LED_GOV_ENABLE
+    // Ticks the LED has not caught up with yet carry over to the new domain
+    uint64_t behind = lite_led_clock_base_q16(g_led_list[id].clock) - g_led_list[id].gov_time_q16;
+    uint64_t base = lite_led_clock_base_q16(clk);
+
+    g_led_list[id].gov_time_q16 = (base > behind) ? base - behind : 0;
+#endif
+    g_led_list[id].clock = clk;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Set a clock domain's speed
+ *
+ * O(1): attached LEDs pick up the new rate on the next poll and continue
+ * from their current phase.
+ *
+ * @param clk Clock domain
+ * @param permille Speed factor x1000 (1000 = real time, 0 = frozen)
+ * @return int Error code
+ */
+int lite_led_clock_set_speed(led_clock_e clk, uint32_t permille)
+{
+    if (clk >= LED_CLOCK_MAX || permille > LED_CLOCK_MAX_SPEED) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_CLOCK_SPEED, (uint8_t)clk, permille);
+#endif
+    lite_led_clock_prepare();
+    g_led_clock[clk].rate_q16 = (uint32_t)(((uint64_t)permille << 16) / 1000u);
+    g_led_clock[clk].scale = (float)g_led_clock[clk].rate_q16 / 65536.0f;
+    g_led_clock[clk].gen++;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Set a clock domain's tempo
+ *
+ * Effects on the domain are authored at LED_CLOCK_REF_BPM; at any other
+ * tempo they run proportionally faster or slower.
+ *
+ * @param clk Clock domain
+ * @param bpm Beats per minute
+ * @return int Error code
+ */
+int lite_led_clock_set_bpm(led_clock_e clk, uint16_t bpm)
+{
+    return lite_led_clock_set_speed(clk, (uint32_t)bpm * 1000u / LED_CLOCK_REF_BPM);
+}
+#endif
+
+#if LED_PULL_ENABLE
+/**
+ * @brief Current time of the LED's clock (Q16 ticks)
+ */
+static uint64_t lite_led_now_q16(const led_dev_t *led)
+{
+#if LED_CLOCK_ENABLE
+    return g_led_clock[led->clock].time_q16;
+#else
+    (void)led;
+    return (uint64_t)g_led_tick << 16;
+#endif
+}
+
+/**
+ * @brief Time of the LED's clock at the end of the poll in progress (Q16 ticks)
+ */
+static uint64_t lite_led_poll_now_q16(const led_dev_t *led)
+{
+#if LED_CLOCK_ENABLE
+    // Domains are advanced before any LED is updated
+    return g_led_clock[led->clock].time_q16;
+#else
+    (void)led;
+    return (uint64_t)(g_led_tick + 1u) << 16;
+#endif
+}
+
+/**
+ * @brief Time of the LED's clock at the start of the last poll that ticked it
+ *
+ * @param now_q16 Time the LED is evaluated at, the end of that poll
+ */
+static uint64_t lite_led_step_q16(const led_dev_t *led, uint64_t now_q16)
+{
+#if LED_CLOCK_ENABLE
+    (void)now_q16;
+    return g_led_clock[led->clock].step_q16;
+#else
+    (void)led;
+    return now_q16 - 65536u;
+#endif
+}
+#endif
+
+#if LED_CHARLIE_ENABLE
+/**
+ * @brief Charlieplexed LEDs are output through the schedule, not a callback
+ */
+static void lite_led_charlie_cb(uint8_t percent)
+{
+    (void)percent;
+}
+
+/**
+ * @brief Rewrite the sub-slots of one LED whose duty changed
+ *
+ * Only the sub-slots between the old and the new duty flip, so a small
+ * brightness change touches a few entries and an unchanged LED none.
+ */
+static void lite_led_charlie_update(uint8_t id, uint8_t percent)
+{
+    led_charlie_slot_t *slot;
+    led_charlie_state_t *sched;
+    led_charlie_state_t lit;
+    uint8_t duty;
+
+    if (g_led_charlie_slot_of[id] == 0) return;
+
+    slot = &g_led_charlie_slot[g_led_charlie_slot_of[id] - 1];
+    duty = (uint8_t)((percent * LED_CHARLIE_LEVELS + LED_MAX_BRIGHTNESS / 2) / LED_MAX_BRIGHTNESS);
+    if (duty > LED_CHARLIE_LEVELS) duty = LED_CHARLIE_LEVELS;
+    if (duty == slot->duty) return;
+
+    sched = &g_led_charlie_sched[(g_led_charlie_slot_of[id] - 1) * LED_CHARLIE_LEVELS];
+    lit.dir = (uint16_t)((1u << slot->anode) | (1u << slot->cathode));
+    lit.out = (uint16_t)(1u << slot->anode);
+
+    for (uint8_t i = duty; i < slot->duty; i++) {
+        sched[i].dir = 0;
+        sched[i].out = 0;
+    }
+    for (uint8_t i = slot->duty; i < duty; i++) {
+        sched[i] = lit;
+    }
+    slot->duty = duty;
+}
+
+/**
+ * @brief Drive an LED through a charlieplexed pin pair
+ *
+ * Initializes the LED and gives it LED_CHARLIE_LEVELS sub-slots in the
+ * pin schedule. Attaching an LED again only changes its pins; its effect
+ * keeps running. A pin pair can drive one LED only.
+ *
+ * @param id LED ID
+ * @param anode Pin driven high to light the LED
+ * @param cathode Pin driven low to light the LED
+ * @return int Error code
+ */
+int lite_led_charlie_attach(uint8_t id, uint8_t anode, uint8_t cathode)
+{
+    led_charlie_slot_t *slot;
+    uint8_t percent;
+    bool attached;
+#if LED_JOURNAL_ENABLE
+    led_journal_rec_t *rec;
+#endif
+
+    if (id >= LED_NUM || anode >= LED_CHARLIE_PIN_NUM || cathode >= LED_CHARLIE_PIN_NUM || anode == cathode) {
+        return LED_ERROR_PARA_INVALID;
+    }
+    for (uint8_t i = 0; i < LED_NUM; i++) {
+        if (i == id || g_led_charlie_slot_of[i] == 0) continue;
+        slot = &g_led_charlie_slot[g_led_charlie_slot_of[i] - 1];
+        if (slot->anode == anode && slot->cathode == cathode) return LED_ERROR_PARA_INVALID;
+    }
+
+#if LED_JOURNAL_ENABLE
+    rec = lite_led_journal_add(LED_JOURNAL_CHARLIE_ATTACH, id, anode);
+    if (rec != NULL) rec->arg[1] = cathode;
+#endif
+    attached = (g_led_charlie_slot_of[id] != 0);
+    if (!attached) {
+        g_led_charlie_slot_of[id] = (uint8_t)(++g_led_charlie_slot_num);
+    }
+    slot = &g_led_charlie_slot[g_led_charlie_slot_of[id] - 1];
+
+    // Blank the slot, then relight it on the new pins
+    percent = (uint8_t)(slot->duty * LED_MAX_BRIGHTNESS / LED_CHARLIE_LEVELS);
+    lite_led_charlie_update(id, LED_MIN_BRIGHTNESS);
+    slot->anode = anode;
+    slot->cathode = cathode;
+    lite_led_charlie_update(id, percent);
+
+    if (attached) return LED_ERROR_NONE;
+
+    return lite_led_setup(id, lite_led_charlie_cb);
+}
+
+/**
+ * @brief Get the whole pin schedule
+ *
+ * One frame is LED_CHARLIE_LEVELS sub-slots per attached LED; play it in a
+ * loop from a timer or DMA. A lit LED's duty is the share of its sub-slots
+ * that drive its pins, other sub-slots leave every pin Hi-Z.
+ *
+ * @param states Output pointer to the first pin state
+ * @return size_t Number of pin states in one frame
+ */
+size_t lite_led_charlie_schedule(const led_charlie_state_t **states)
+{
+    if (states != NULL) *states = g_led_charlie_sched;
+
+    return g_led_charlie_slot_num * LED_CHARLIE_LEVELS;
+}
+
+/**
+ * @brief Get the next pin state of the schedule
+ *
+ * Call from the multiplexing timer interrupt and apply the state to the
+ * port; on a host, collect the stream to check the output.
+ *
+ * @param state Output pin state
+ * @return int Error code
+ */
+int lite_led_charlie_next(led_charlie_state_t *state)
+{
+    size_t len = g_led_charlie_slot_num * LED_CHARLIE_LEVELS;
+
+    if (state == NULL || len == 0) return LED_ERROR_PARA_INVALID;
+
+    if (g_led_charlie_pos >= len) g_led_charlie_pos = 0;
+    *state = g_led_charlie_sched[g_led_charlie_pos++];
+
+    return LED_ERROR_NONE;
+}
+#endif
+
+#if LED_OUT_LUT_ENABLE
+/**
+ * @brief Recompute the output tables from calibration and master level
+ *
+ * Runs only when the calibration or the master level changes, never per
+ * tick: the scaling is folded into the table the output stage reads.
+ */
+static void lite_led_out_rebuild(void)
+{
+    uint32_t scale_q8 = ((uint32_t)g_led_master_q8 * g_led_derate_q8 + 128u) >> 8;
+    uint32_t base;
+
+    for (uint8_t bin = 0; bin < LED_OUT_BIN_NUM; bin++) {
+        for (uint32_t i = 0; i < 256; i++) {
+#if LED_CALIB_ENABLE
+            base = g_led_calib_lut[bin][i];
+#else
+            base = (i > LED_MAX_BRIGHTNESS) ? LED_MAX_BRIGHTNESS : i;
+#endif
+            g_led_out_lut[bin][i] = (uint8_t)((base * scale_q8 + 128u) >> 8);
+        }
+    }
+}
+#endif
+
+#if LED_OUT_LUT_ENABLE
+/**
+ * @brief Rebuild the output tables and re-output every LED through them
+ *
+ * LEDs parked on LED_BLOCK_FOREVER would otherwise keep the old level.
+ */
+static void lite_led_out_apply(void)
+{
+    lite_led_out_rebuild();
+    g_led_out_ready = true;
+
+    for (size_t i = 0; i < LED_NUM; i++) {
+        if (g_led_list[i].set_percent_cb == NULL) continue;
+#if LED_PULL_ENABLE
+        if (lite_led_is_lazy(&g_led_list[i])) continue;
+#endif
+#if LED_CCT_ENABLE
+        if (lite_led_cct_is_slave(&g_led_list[i])) continue;
+#endif
+        lite_led_output(&g_led_list[i]);
+    }
+}
+#endif
+
+#if LED_CALIB_ENABLE
+/**
+ * @brief Fill one bin's calibration table
+ *
+ * @param bin Bin index
+ * @param gain_q8 Gain (Q8, 256 = 1.0)
+ * @param offset Offset in percent, added after the gain
+ * @param curve Response curve (LED_MAX_BRIGHTNESS + 1 entries), NULL = linear
+ */
+static void lite_led_calib_build(uint8_t bin, uint16_t gain_q8, int8_t offset, const uint8_t *curve)
+{
+    int32_t value;
+    uint8_t in;
+
+    for (uint32_t i = 0; i < 256; i++) {
+        in = (i > LED_MAX_BRIGHTNESS) ? LED_MAX_BRIGHTNESS : (uint8_t)i;
+        value = (curve != NULL) ? curve[in] : in;
+        value = ((value * gain_q8 + 128) >> 8) + offset;
+        if (value < LED_MIN_BRIGHTNESS) value = LED_MIN_BRIGHTNESS;
+        if (value > LED_MAX_BRIGHTNESS) value = LED_MAX_BRIGHTNESS;
+        g_led_calib_lut[bin][i] = (uint8_t)value;
+    }
+}
+
+/**
+ * @brief Reset every bin to the identity and every LED to bin 0
+ */
+static void lite_led_calib_reset(void)
+{
+    for (uint8_t bin = 0; bin < LED_CALIB_BIN_NUM; bin++) {
+        lite_led_calib_build(bin, 256, 0, NULL);
+    }
+    memset(g_led_calib_bin, 0, sizeof(g_led_calib_bin));
+}
+#endif
+
+#if LED_OUT_LUT_ENABLE
+/**
+ * @brief Build the output tables on first use
+ */
+static void lite_led_out_prepare(void)
+{
+    if (g_led_out_ready) return;
+
+#if LED_CALIB_ENABLE
+    lite_led_calib_reset();
+#endif
+    lite_led_out_rebuild();
+    g_led_out_ready = true;
+}
+#endif
+
+#if LED_CALIB_ENABLE
+/**
+ * @brief Load calibration from a binary image
+ *
+ * Image layout (little endian):
+ *   - header: "LLCB", version (1), bin count, LED count, reserved
+ *   - per bin: gain (u16, Q8), offset (s8, percent), curve flag (u8),
+ *     followed by LED_MAX_BRIGHTNESS + 1 curve bytes if the flag is 1
+ *   - per LED: bin index (u8)
+ *
+ * Calibration is folded into each bin's output table, so a calibrated
+ * LED costs the same single lookup as an uncalibrated one. The image is
+ * fully validated before anything is applied; curve flags other than 0
+ * and 1 are rejected.
+ *
+ * @param data Image, e.g. read from a file or flash at startup
+ * @param len Image size in bytes
+ * @return int Error code
+ */
+int lite_led_calib_load(const uint8_t *data, size_t len)
+{
+    const uint8_t *p;
+    uint8_t bin_num, led_num;
+    size_t off;
+
+    if (data == NULL || len < LED_CALIB_HDR_SIZE) return LED_ERROR_PARA_INVALID;
+    if (memcmp(data, LED_CALIB_MAGIC, 4) != 0 || data[4] != LED_CALIB_VERSION) return LED_ERROR_PARA_INVALID;
+
+    bin_num = data[5];
+    led_num = data[6];
+    if (bin_num == 0 || bin_num > LED_CALIB_BIN_NUM || led_num > LED_NUM) return LED_ERROR_PARA_INVALID;
+
+    // Validation pass, on offsets so that nothing points past the image
+    off = LED_CALIB_HDR_SIZE;
+    for (uint8_t bin = 0; bin < bin_num; bin++) {
+        if (len - off < 4u || data[off + 3] > 1) return LED_ERROR_PARA_INVALID;
+        if (data[off + 3] == 1) {
+            if (len - off - 4u < LED_MAX_BRIGHTNESS + 1u) return LED_ERROR_PARA_INVALID;
+            off += LED_MAX_BRIGHTNESS + 1u;
+        }
+        off += 4u;
+    }
+    if (len - off < led_num) return LED_ERROR_PARA_INVALID;
+    for (uint8_t i = 0; i < led_num; i++) {
+        if (data[off + i] >= bin_num) return LED_ERROR_PARA_INVALID;
+    }
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_unsupported(LED_JOURNAL_CALIB_LOAD, 0);
+#endif
+    // Apply pass
+    lite_led_calib_reset();
+    p = data + LED_CALIB_HDR_SIZE;
+    for (uint8_t bin = 0; bin < bin_num; bin++) {
+        lite_led_calib_build(bin, (uint16_t)(p[0] | (p[1] << 8)), (int8_t)p[2], (p[3] == 1) ? p + 4 : NULL);
+        p += 4u + ((p[3] == 1) ? LED_MAX_BRIGHTNESS + 1u : 0u);
+    }
+    memcpy(g_led_calib_bin, p, led_num);
+    lite_led_out_apply();
+
+    return LED_ERROR_NONE;
+}
+#endif
+
+#if LED_MASTER_ENABLE
+/**
+ * @brief Set the master level applied to every LED's output
+ *
+ * Folded into the output tables, so it costs nothing per tick.
+ *
+ * @param percent Master level (0-100%)
+ * @return int Error code
+ */
+int lite_led_set_master(uint8_t percent)
+{
+    if (percent > LED_MAX_BRIGHTNESS) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_MASTER, 0, percent);
+#endif
+    g_led_master_q8 = (uint16_t)(((uint32_t)percent << 8) / LED_MAX_BRIGHTNESS);
+    lite_led_out_apply();
+
+    return LED_ERROR_NONE;
+}
+#endif
+
+#if LED_THERMAL_ENABLE
+/**
+ * @brief Feed a measured temperature
+ *
+ * Once fed, the sensor value replaces the built-in power estimate.
+ *
+ * @param temp_dc Temperature in 0.1 degC
+ * @return int Error code
+ */
+int lite_led_thermal_set_temp(int16_t temp_dc)
+{
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_THERMAL, 0, (uint32_t)(int32_t)temp_dc);
+#endif
+    g_led_thermal_temp_q8 = (int32_t)temp_dc * 256;
+    g_led_thermal_sensor = true;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Update the thermal model and the derating factor
+ *
+ * Called every LED_THERMAL_PERIOD_MS. Without a sensor, the temperature
+ * follows a first-order model driven by the average output level of the
+ * initialized LEDs; slots that were never set up do not dilute it.
+ */
+static void lite_led_thermal_step(void)
+{
+    int32_t temp;
+    int32_t target;
+    uint32_t sum = 0;
+    uint32_t used = 0;
+    uint16_t derate_q8;
+
+    if (!g_led_thermal_sensor) {
+        for (size_t i = 0; i < LED_NUM; i++) {
+            if (g_led_list[i].set_percent_cb == NULL) continue;
+            sum += g_led_list[i].stat.percent;
+            used++;
+        }
+        // Dissipation follows what is actually output, i.e. after derating
+        sum = (sum * g_led_master_q8 >> 8) * g_led_derate_q8 >> 8;
+        target = LED_THERMAL_AMBIENT_DC * 256;
+        if (used != 0) target += (int32_t)(sum * LED_THERMAL_RISE_DC / (used * LED_MAX_BRIGHTNESS)) * 256;
+        g_led_thermal_temp_q8 += (int32_t)((int64_t)(target - g_led_thermal_temp_q8) * LED_THERMAL_PERIOD_MS / LED_THERMAL_TAU_MS);
+    }
+    temp = g_led_thermal_temp_q8 / 256;
+
+    if (temp <= LED_THERMAL_START_DC) {
+        derate_q8 = 256;
+    } else if (temp >= LED_THERMAL_LIMIT_DC) {
+        derate_q8 = LED_THERMAL_MIN_PERCENT * 256 / LED_MAX_BRIGHTNESS;
+    } else {
+        derate_q8 = (uint16_t)(256 - (256 - LED_THERMAL_MIN_PERCENT * 256 / LED_MAX_BRIGHTNESS) *
+                               (temp - LED_THERMAL_START_DC) / (LED_THERMAL_LIMIT_DC - LED_THERMAL_START_DC));
+    }
+
+    if (derate_q8 != g_led_derate_q8) {
+        g_led_derate_q8 = derate_q8;
+        lite_led_out_apply();
+    }
+}
+#endif
+
+/**
+ * @brief Send an output value to the LED's callback and backends
+ */
+static void lite_led_send(led_dev_t *led, uint8_t percent)
+{
+#if LED_OUT_LUT_ENABLE
+    percent = g_led_out_lut[LED_OUT_BIN(led->id)][percent];
+#endif
+#if LED_JOURNAL_ENABLE
+    g_led_journal_sent[led->id] = (g_led_journal_sent[led->id] ^ percent) * LED_JOURNAL_FNV_PRIME;
+#endif
+    if (led->set_percent_cb != NULL) led->set_percent_cb(percent);
+#if LED_STRIP_ENABLE
+    // Kept for every LED, so that binding one picks up what it shows
+    if (g_led_palette_level[led->id] != percent) {
+        g_led_palette_level[led->id] = percent;
+        if (g_led_palette_bound[led->id]) g_led_palette_dirty = true;
+    }
+#endif
+#if LED_CHARLIE_ENABLE
+    lite_led_charlie_update(led->id, percent);
+#endif
+}
+
+/**
+ * @brief Hand a new key value of an LED to the output
+ *
+ * With output interpolation, smooth values become the target of the LED's
+ * stepper and are sent by lite_led_output_poll(); edges are sent at once.
+ *
+ * @param led LED device
+ * @param percent Key value computed by the engine
+ * @param smooth true if the value belongs to a continuous effect
+ */
+static void lite_led_emit(led_dev_t *led, uint8_t percent, bool smooth)
+{
+#if LED_OUTPUT_INTERP_ENABLE
+    led_interp_t *ip = &g_led_interp[led->id];
+
+    if (smooth) {
+        ip->target = percent;
+        ip->step_q8 = (int16_t)((((int32_t)percent << 8) - ip->level_q8) / LED_OUTPUT_INTERP_STEPS);
+        ip->steps = LED_OUTPUT_INTERP_STEPS;
+        return;
+    }
+    ip->level_q8 = (uint16_t)(percent << 8);
+    ip->sent = percent;
+    ip->steps = 0;
+#else
+    (void)smooth;
+#endif
+    lite_led_send(led, percent);
+}
+
+#if LED_CCT_ENABLE
+/**
+ * @brief Build the CCT-to-mix table
+ *
+ * Mixing two whites is linear in mired (1e6 / K), not in kelvin, so the
+ * cold share is computed in mired and sampled at evenly spaced CCTs.
+ */
+static void lite_led_cct_build_mix(void)
+{
+    const uint32_t warm_mired = 1000000u / LED_CCT_MIN_K;
+    const uint32_t cold_mired = 1000000u / LED_CCT_MAX_K;
+    uint32_t cct, mired;
+
+    for (uint32_t i = 0; i < LED_CCT_LUT_SIZE; i++) {
+        cct = LED_CCT_MIN_K + (LED_CCT_MAX_K - LED_CCT_MIN_K) * i / (LED_CCT_LUT_SIZE - 1);
+        mired = 1000000u / cct;
+        g_led_cct_mix[i] = (uint16_t)(((warm_mired - mired) << 8) / (warm_mired - cold_mired));
+    }
+    g_led_cct_mix_ready = true;
+}
+
+/**
+ * @brief Output a tunable-white entity
+ *
+ * The warm LED's brightness is split between both channels by the cold
+ * share of the current CCT, in integer math.
+ */
+static void lite_led_cct_output(const led_cct_t *cct, uint8_t percent, bool smooth)
+{
+    uint32_t k = cct->cct_q8 >> 8;
+    uint32_t share = g_led_cct_mix[(k - LED_CCT_MIN_K) * (LED_CCT_LUT_SIZE - 1) / (LED_CCT_MAX_K - LED_CCT_MIN_K)];
+
+    lite_led_emit(&g_led_list[cct->warm_id], (uint8_t)((percent * (256u - share) + 128u) >> 8), smooth);
+    lite_led_emit(&g_led_list[cct->cold_id], (uint8_t)((percent * share + 128u) >> 8), smooth);
+}
+
+/**
+ * @brief Advance the CCT fade of the entity led a warm LED leads
+ *
+ * @return bool true if the CCT changed (the entity must be output)
+ */
+static bool lite_led_cct_step(const led_dev_t *led)
+{
+    led_cct_t *cct;
+
+    if (g_led_cct_of[led->id] == 0) return false;
+
+    cct = &g_led_cct[g_led_cct_of[led->id] - 1];
+    if (cct->warm_id != led->id || cct->fade_tick == 0) return false;
+
+    cct->cct_q8 = (uint32_t)((int32_t)cct->cct_q8 + cct->step_q8);
+    cct->fade_tick--;
+
+    return true;
+}
+
+/**
+ * @brief Check whether an LED is the slaved cold channel of an entity
+ */
+static bool lite_led_cct_is_slave(const led_dev_t *led)
+{
+    return g_led_cct_of[led->id] != 0 && g_led_cct[g_led_cct_of[led->id] - 1].cold_id == led->id;
+}
+
+/**
+ * @brief Combine two initialized LEDs into a tunable-white entity
+ *
+ * Brightness effects are written to the warm LED as usual; the cold LED
+ * no longer runs its own effect. The entity starts at LED_CCT_MIN_K.
+ * Initializing an entity again releases its old channels, which go back
+ * to showing their own effects; channels of another entity are refused.
+ *
+ * @param n Entity index (0 ~ LED_CCT_NUM-1)
+ * @param warm_id Warm white channel
+ * @param cold_id Cold white channel
+ * @return int Error code
+ */
+int lite_led_cct_init(uint8_t n, uint8_t warm_id, uint8_t cold_id)
+{
+    uint8_t old[2] = { LED_NUM, LED_NUM };
+#if LED_JOURNAL_ENABLE
+    led_journal_rec_t *rec;
+#endif
+
+    if (n >= LED_CCT_NUM || warm_id >= LED_NUM || cold_id >= LED_NUM || warm_id == cold_id) {
+        return LED_ERROR_PARA_INVALID;
+    }
+    // Both channels are driven through their own callbacks
+    if (g_led_list[warm_id].set_percent_cb == NULL || g_led_list[cold_id].set_percent_cb == NULL) {
+        return LED_ERROR_PARA_INVALID;
+    }
+    if ((g_led_cct_of[warm_id] != 0 && g_led_cct_of[warm_id] != n + 1) ||
+        (g_led_cct_of[cold_id] != 0 && g_led_cct_of[cold_id] != n + 1)) {
+        return LED_ERROR_PARA_INVALID;
+    }
+
+#if LED_JOURNAL_ENABLE
+    rec = lite_led_journal_add(LED_JOURNAL_CCT_INIT, n, warm_id);
+    if (rec != NULL) rec->arg[1] = cold_id;
+#endif
+
+    if (!g_led_cct_mix_ready) lite_led_cct_build_mix();
+
+#if LED_TIMER_SCAN_ENABLE
+    lite_led_timer_wake(warm_id);
+    lite_led_timer_wake(cold_id);
+#endif
+    if (g_led_cct_of[g_led_cct[n].warm_id] == n + 1) {
+        old[0] = g_led_cct[n].warm_id;
+        old[1] = g_led_cct[n].cold_id;
+        g_led_cct_of[old[0]] = 0;
+        g_led_cct_of[old[1]] = 0;
+    }
+    memset(&g_led_cct[n], 0, sizeof(g_led_cct[n]));
+    g_led_cct[n].warm_id = warm_id;
+    g_led_cct[n].cold_id = cold_id;
+    g_led_cct[n].cct_q8 = (uint32_t)LED_CCT_MIN_K << 8;
+    g_led_cct_of[warm_id] = n + 1;
+    g_led_cct_of[cold_id] = n + 1;
+
+    // Released channels still show the mix: hand them their own level
+    for (size_t i = 0; i < 2; i++) {
+        if (old[i] == LED_NUM || g_led_cct_of[old[i]] != 0) continue;
+#if LED_TIMER_SCAN_ENABLE
+        lite_led_timer_wake(old[i]);
+#endif
+        lite_led_output(&g_led_list[old[i]]);
+    }
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Set or fade the color temperature of an entity
+ *
+ * @param n Entity index
+ * @param cct_k Target color temperature (LED_CCT_MIN_K ~ LED_CCT_MAX_K)
+ * @param fade_ms Fade time in milliseconds (0 = immediate)
+ * @return int Error code
+ */
+int lite_led_cct_write(uint8_t n, uint16_t cct_k, uint32_t fade_ms)
+{
+    led_cct_t *cct;
+    size_t ticks = fade_ms / LED_POLL_PERIOD_MS;
+#if LED_JOURNAL_ENABLE
+    led_journal_rec_t *rec;
+#endif
+
+    if (n >= LED_CCT_NUM || cct_k < LED_CCT_MIN_K || cct_k > LED_CCT_MAX_K) return LED_ERROR_PARA_INVALID;
+
+    cct = &g_led_cct[n];
+    if (g_led_cct_of[cct->warm_id] != n + 1) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    rec = lite_led_journal_add(LED_JOURNAL_CCT_WRITE, n, cct_k);
+    if (rec != NULL) rec->arg[1] = fade_ms;
+#endif
+
+    if (ticks == 0) ticks = 1;
+    cct->step_q8 = (((int32_t)cct_k << 8) - (int32_t)cct->cct_q8) / (int32_t)ticks;
+    cct->fade_tick = ticks;
+    // Land exactly on the target on the last tick
+    cct->cct_q8 = ((uint32_t)cct_k << 8) - (uint32_t)(cct->step_q8 * (int32_t)ticks);
+
+    return LED_ERROR_NONE;
+}
+#endif
+
+#if LED_MOD_ENABLE
+/**
+ * @brief Reset every LED to unmodulated on first use
+ */
+static void lite_led_mod_prepare(void)
+{
+    if (g_led_mod_ready) return;
+
+    for (size_t i = 0; i < LED_NUM; i++) {
+        g_led_mod[i].speed = 1.0f;
+        g_led_mod[i].level_q8 = 256;
+        g_led_mod[i].level_routed = false;
+    }
+    g_led_mod_ready = true;
+}
+
+/**
+ * @brief Configure a modulation source
+ *
+ * @param n Source index (0 ~ LED_LFO_NUM-1)
+ * @param shape Waveform
+ * @param period_ms Cycle time in milliseconds
+ * @return int Error code
+ */
+int lite_led_lfo_set(uint8_t n, led_lfo_shape_e shape, uint32_t period_ms)
+{
+#if LED_JOURNAL_ENABLE
+    led_journal_rec_t *rec;
+#endif
+
+    if (n >= LED_LFO_NUM || shape > LED_LFO_SAW || period_ms < LED_POLL_PERIOD_MS) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    rec = lite_led_journal_add(LED_JOURNAL_LFO, n, shape);
+    if (rec != NULL) rec->arg[1] = period_ms;
+#endif
+    g_led_lfo[n].shape = shape;
+    g_led_lfo[n].step_q16 = (uint32_t)(((uint64_t)LED_POLL_PERIOD_MS << 16) / period_ms);
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Route a source to an LED's effect parameter
+ *
+ * LED_MOD_SPEED scales the BREATH/FADE phase step by 1 + depth * lfo;
+ * LED_MOD_LEVEL scales the brightness between 1 - depth and 1. Several
+ * routes to the same target multiply. A depth of 0 removes the route.
+ *
+ * @param n Route index (0 ~ LED_MOD_ROUTE_NUM-1)
+ * @param lfo Source index
+ * @param id LED ID
+ * @param dest Target parameter
+ * @param depth_percent Modulation depth (0-100%)
+ * @return int Error code
+ */
+int lite_led_mod_route(uint8_t n, uint8_t lfo, uint8_t id, led_mod_dest_e dest, uint8_t depth_percent)
+{
+#if LED_JOURNAL_ENABLE
+    led_journal_rec_t *rec;
+#endif
+
+    if (n >= LED_MOD_ROUTE_NUM || lfo >= LED_LFO_NUM || id >= LED_NUM) return LED_ERROR_PARA_INVALID;
+    if (dest > LED_MOD_LEVEL || depth_percent > 100) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    rec = lite_led_journal_add(LED_JOURNAL_MOD_ROUTE, n, lfo);
+    if (rec != NULL) {
+        rec->arg[1] = id;
+        rec->arg[2] = dest;
+        rec->arg[3] = depth_percent;
+    }
+#endif
+
+    lite_led_mod_prepare();
+#if LED_TIMER_SCAN_ENABLE
+    lite_led_timer_wake(g_led_mod_route[n].id);
+    lite_led_timer_wake(id);
+#endif
+
+    // The previous target of this route goes back to unmodulated
+    g_led_mod[g_led_mod_route[n].id].speed = 1.0f;
+    g_led_mod[g_led_mod_route[n].id].level_q8 = 256;
+    g_led_mod[g_led_mod_route[n].id].level_routed = false;
+    g_led_mod[g_led_mod_route[n].id].refresh = true;
+
+    g_led_mod_route[n].lfo = lfo;
+    g_led_mod_route[n].id = id;
+    g_led_mod_route[n].dest = dest;
+    g_led_mod_route[n].depth = depth_percent / 100.0f;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Evaluate every source once and apply the routes
+ *
+ * O(sources + routes) per poll; the per-LED update only reads the result.
+ */
+static void lite_led_mod_advance(void)
+{
+    led_lfo_t *lfo;
+    led_mod_route_t *route;
+    led_mod_t *mod;
+    float p, v;
+
+    lite_led_mod_prepare();
+
+    for (size_t i = 0; i < LED_LFO_NUM; i++) {
+        lfo = &g_led_lfo[i];
+        if (lfo->step_q16 == 0) continue;
+        lfo->phase_q16 = (lfo->phase_q16 + lfo->step_q16) & 0xFFFF;
+        p = (float)lfo->phase_q16 / 65536.0f;
+        switch (lfo->shape) {
+            case LED_LFO_SINE:      v = sinf((float)LED_2PI * p); break;
+            case LED_LFO_TRIANGLE:  v = (p < 0.5f) ? (4.0f * p - 1.0f) : (3.0f - 4.0f * p); break;
+            case LED_LFO_SQUARE:    v = (p < 0.5f) ? 1.0f : -1.0f; break;
+            default:                v = 2.0f * p - 1.0f; break;
+        }
+        lfo->value = v;
+    }
+
+    // Targets of active routes start from neutral, then every route multiplies in
+    for (size_t i = 0; i < LED_MOD_ROUTE_NUM; i++) {
+        route = &g_led_mod_route[i];
+        if (route->depth == 0.0f) continue;
+        g_led_mod[route->id].speed = 1.0f;
+        g_led_mod[route->id].level_q8 = 256;
+    }
+    for (size_t i = 0; i < LED_MOD_ROUTE_NUM; i++) {
+        route = &g_led_mod_route[i];
+        if (route->depth == 0.0f) continue;
+        mod = &g_led_mod[route->id];
+        v = g_led_lfo[route->lfo].value;
+        if (route->dest == LED_MOD_SPEED) {
+            mod->speed *= 1.0f + route->depth * v;
+        } else {
+            mod->level_q8 = (uint16_t)(mod->level_q8 * (1.0f - route->depth * (1.0f - v) * 0.5f));
+            mod->level_routed = true;
+        }
+    }
+}
+#endif
+
+#if LED_STRIP_ENABLE
+/**
+ * @brief Attach a pixel strip
+ *
+ * Pixels hold 8-bit palette indices; the frame buffer receives the wire
+ * bytes when the strip is transmitted. All pixels start at index 0 and
+ * the whole strip is sent at the first poll.
+ *
+ * With a port attached, the port buffer must hold the strip's stream.
+ *
+ * @param n Strip index (0 ~ LED_STRIP_NUM-1)
+ * @param pixels Index buffer of count bytes
+ * @param frame Output buffer of count * 3 bytes
+ * @param count Number of pixels
+ * @param cb Transmit callback
+ * @return int Error code
+ */
+int lite_led_strip_init(uint8_t n, uint8_t *pixels, uint8_t *frame, uint16_t count, led_strip_write_f cb)
+{
+    if (n >= LED_STRIP_NUM || pixels == NULL || frame == NULL || count == 0 || cb == NULL) {
+        return LED_ERROR_PARA_INVALID;
+    }
+    if (g_led_port_buf != NULL && (size_t)count * 3 * LED_STRIP_PORT_WIDTH > g_led_port_size) {
+        return LED_ERROR_PARA_INVALID;
+    }
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_unsupported(LED_JOURNAL_STRIP_INIT, n);
+#endif
+    memset(pixels, 0, count);
+    g_led_strip[n].pixels = pixels;
+    g_led_strip[n].frame = frame;
+    g_led_strip[n].count = count;
+    g_led_strip[n].write_cb = cb;
+    g_led_strip[n].dirty_lo = 0;
+    g_led_strip[n].dirty_hi = count;
+    g_led_strip[n].truncate = false;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Allow a strip to be sent only up to its last changed pixel
+ *
+ * For daisy-chained protocols where pixels past the end of a short frame
+ * keep their color (WS2812 reset latch, APA102 end frame, ...). The frame
+ * always starts at the first pixel; the length shrinks to the dirty extent.
+ *
+ * @param n Strip index
+ * @param enable true to send truncated frames
+ * @return int Error code
+ */
+int lite_led_strip_truncate(uint8_t n, bool enable)
+{
+    if (n >= LED_STRIP_NUM) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_STRIP_TRUNCATE, n, enable);
+#endif
+    g_led_strip[n].truncate = enable;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Grow a strip's dirty extent to cover [lo, hi)
+ */
+static void lite_led_strip_mark(led_strip_t *strip, uint16_t lo, uint16_t hi)
+{
+    if (lo >= hi) return;
+
+    if (strip->dirty_hi == 0) {
+        strip->dirty_lo = lo;
+        strip->dirty_hi = hi;
+        return;
+    }
+    if (lo < strip->dirty_lo) strip->dirty_lo = lo;
+    if (hi > strip->dirty_hi) strip->dirty_hi = hi;
+}
+
+/**
+ * @brief Write palette indices to a run of pixels
+ *
+ * @param n Strip index
+ * @param pos First pixel
+ * @param index Palette indices
+ * @param len Number of pixels
+ * @return int Error code
+ */
+int lite_led_strip_set(uint8_t n, uint16_t pos, const uint8_t *index, uint16_t len)
+{
+    led_strip_t *strip;
+
+    if (n >= LED_STRIP_NUM || index == NULL) return LED_ERROR_PARA_INVALID;
+
+    strip = &g_led_strip[n];
+    if (strip->pixels == NULL || (uint32_t)pos + len > strip->count) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_unsupported(LED_JOURNAL_STRIP_SET, n);
+#endif
+    memcpy(&strip->pixels[pos], index, len);
+    lite_led_strip_mark(strip, pos, (uint16_t)(pos + len));
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Set the base color of a palette entry
+ *
+ * Every pixel holding this index changes color at the next poll.
+ *
+ * @param index Palette entry
+ * @param color Color at full brightness
+ * @return int Error code
+ */
+int lite_led_palette_set(uint8_t index, led_rgb_t color)
+{
+#if LED_JOURNAL_ENABLE
+    led_journal_rec_t *rec = lite_led_journal_add(LED_JOURNAL_PALETTE_SET, index, color.r);
+
+    if (rec != NULL) {
+        rec->arg[1] = color.g;
+        rec->arg[2] = color.b;
+    }
+#endif
+    g_led_palette[index] = color;
+    g_led_palette_dirty = true;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Let an LED effect animate a palette entry
+ *
+ * The entry's color is scaled by the LED's output, so a BREATH or TRACK
+ * on the LED animates every pixel holding the index. The LED still needs
+ * lite_led_init(); its callback may do nothing.
+ *
+ * @param index Palette entry
+ * @param id LED ID, LED_INVALID to unbind
+ * @return int Error code
+ */
+int lite_led_palette_bind(uint8_t index, uint8_t id)
+{
+    uint8_t old = g_led_palette_bind[index];
+
+    if (id >= LED_NUM && id != LED_INVALID) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_PALETTE_BIND, index, id);
+#endif
+    g_led_palette_bind[index] = (id == LED_INVALID) ? 0 : (uint8_t)(id + 1);
+    if (id != LED_INVALID) g_led_palette_bound[id] = true;
+
+    // Drop the old LED's flag once no entry refers to it
+    if (old && old != g_led_palette_bind[index]) {
+        g_led_palette_bound[old - 1] = false;
+        for (size_t i = 0; i < LED_PALETTE_SIZE; i++) {
+            if (g_led_palette_bind[i] == old) {
+                g_led_palette_bound[old - 1] = true;
+                break;
+            }
+        }
+    }
+    g_led_palette_dirty = true;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Scale the base colors into the wire-order output palette
+ *
+ * O(256) regardless of the number of pixels.
+ *
+ * @param changed Bitmap of entries whose output color changed
+ * @return true if any entry changed
+ */
+static bool lite_led_palette_rebuild(uint32_t changed[LED_PALETTE_SIZE / 32])
+{
+    const led_rgb_t *c;
+    uint8_t *o;
+    uint8_t rgb[3];
+    uint16_t level;
+    bool any = false;
+
+    memset(changed, 0, LED_PALETTE_SIZE / 8);
+    for (size_t i = 0; i < LED_PALETTE_SIZE; i++) {
+        c = &g_led_palette[i];
+        o = g_led_palette_out[i];
+        level = g_led_palette_bind[i] ? g_led_palette_level[g_led_palette_bind[i] - 1] : LED_MAX_BRIGHTNESS;
+        rgb[LED_STRIP_R_OFS] = (uint8_t)((c->r * level + 50) / 100);
+        rgb[LED_STRIP_G_OFS] = (uint8_t)((c->g * level + 50) / 100);
+        rgb[LED_STRIP_B_OFS] = (uint8_t)((c->b * level + 50) / 100);
+        if (memcmp(o, rgb, 3) != 0) {
+            memcpy(o, rgb, 3);
+            changed[i / 32] |= 1u << (i % 32);
+            any = true;
+        }
+    }
+
+    return any;
+}
+
+/**
+ * @brief Grow a strip's dirty extent over the pixels holding changed entries
+ *
+ * Scans inwards from both ends, so it stops at the first and last hit.
+ */
+static void lite_led_strip_mark_palette(led_strip_t *strip, const uint32_t changed[LED_PALETTE_SIZE / 32])
+{
+    uint16_t lo = 0;
+    uint16_t hi = strip->count;
+    uint8_t idx;
+
+    while (lo < hi) {
+        idx = strip->pixels[lo];
+        if (changed[idx / 32] & (1u << (idx % 32))) break;
+        lo++;
+    }
+    while (hi > lo) {
+        idx = strip->pixels[hi - 1];
+        if (changed[idx / 32] & (1u << (idx % 32))) break;
+        hi--;
+    }
+    lite_led_strip_mark(strip, lo, hi);
+}
+
+/**
+ * @brief Transpose an 8x8 bit matrix held in a 64-bit word
+ *
+ * Bit c of byte r moves to bit r of byte c, in three swap rounds.
+ */
+static uint64_t lite_led_transpose8(uint64_t x)
+{
+    uint64_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAull;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;
+    x = x ^ t ^ (t << 28);
+
+    return x;
+}
+
+/**
+ * @brief Gather byte k of eight strips into one word, strip s in byte s
+ */
+static uint64_t lite_led_strip_gather(const uint8_t *const *frames, const size_t *lens,
+                                      uint8_t first, uint8_t num, size_t k)
+{
+    uint64_t x = 0;
+
+    for (uint8_t s = 0; s < 8 && first + s < num; s++) {
+        if (frames[first + s] != NULL && k < lens[first + s]) {
+            x |= (uint64_t)frames[first + s][k] << (8 * s);
+        }
+    }
+
+    return x;
+}
+
+/**
+ * @brief Bit-transpose strip frames into a parallel port stream
+ *
+ * Every frame byte becomes 8 port words, MSB first; bit s of a word is the
+ * data line of strip s. Words are LED_STRIP_PORT_WIDTH bits wide. Strips
+ * that are missing, NULL or shorter than len are sent as zeros.
+ *
+ * @param frames Wire bytes per strip
+ * @param lens Length of each frame in bytes
+ * @param num Number of strips (<= LED_STRIP_PORT_WIDTH)
+ * @param len Bytes per strip to encode
+ * @param out Port words, len * 8 of them, in native byte order; any alignment
+ * @return size_t Bytes written to out, 0 on invalid parameters
+ */
+size_t lite_led_strip_encode(const uint8_t *const *frames, const size_t *lens, uint8_t num, size_t len, void *out)
+{
+    uint64_t lo;
+#if LED_STRIP_PORT_WIDTH == 16
+    uint64_t hi;
+    uint16_t word;
+#endif
+
+    if (frames == NULL || lens == NULL || out == NULL || num > LED_STRIP_PORT_WIDTH) return 0;
+
+    for (size_t k = 0; k < len; k++) {
+        lo = lite_led_transpose8(lite_led_strip_gather(frames, lens, 0, num, k));
+#if LED_STRIP_PORT_WIDTH == 8
+        for (int b = 0; b < 8; b++) {
+            ((uint8_t *)out)[k * 8 + b] = (uint8_t)(lo >> (8 * (7 - b)));
+        }
+#else
+        hi = lite_led_transpose8(lite_led_strip_gather(frames, lens, 8, num, k));
+        for (int b = 0; b < 8; b++) {
+            word = (uint16_t)(((lo >> (8 * (7 - b))) & 0xFF) | (((hi >> (8 * (7 - b))) & 0xFF) << 8));
+            // The caller's buffer may be a byte buffer at an odd address
+            memcpy((uint8_t *)out + (k * 8 + b) * sizeof(word), &word, sizeof(word));
+        }
+#endif
+    }
+
+    return len * LED_STRIP_PORT_WIDTH;
+}
+
+/**
+ * @brief Send all strips as one parallel stream instead of one by one
+ *
+ * The stream is as long as the longest frame that needs sending; buf must
+ * hold LED_STRIP_PORT_WIDTH bytes per frame byte of the longest strip,
+ * attached now or later. Strip write callbacks are not used while a port
+ * is attached.
+ *
+ * @param buf Stream buffer, NULL to detach
+ * @param size Size of buf in bytes
+ * @param cb Port transmit callback
+ * @return int Error code
+ */
+int lite_led_strip_port_init(uint8_t *buf, size_t size, led_strip_write_f cb)
+{
+    if (buf != NULL && (cb == NULL || size < LED_STRIP_PORT_WIDTH)) return LED_ERROR_PARA_INVALID;
+    for (size_t n = 0; buf != NULL && n < LED_STRIP_NUM; n++) {
+        if ((size_t)g_led_strip[n].count * 3 * LED_STRIP_PORT_WIDTH > size) return LED_ERROR_PARA_INVALID;
+    }
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_unsupported(LED_JOURNAL_STRIP_PORT, 0);
+#endif
+    g_led_port_buf = buf;
+    g_led_port_size = size;
+    g_led_port_cb = cb;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Render and transmit the strips that changed
+ *
+ * Only the dirty extent of a strip is rendered. A truncating strip is sent
+ * from the first pixel up to its last changed pixel, others in full.
+ */
+static void lite_led_strip_flush(void)
+{
+    uint32_t changed[LED_PALETTE_SIZE / 32];
+    led_strip_t *strip;
+    const uint8_t *frames[LED_STRIP_NUM];
+    size_t lens[LED_STRIP_NUM];
+    const uint8_t *src;
+    uint8_t *dst;
+    size_t len;
+    size_t port_len = 0;
+
+    if (g_led_palette_dirty) {
+        if (lite_led_palette_rebuild(changed)) {
+            for (size_t n = 0; n < LED_STRIP_NUM; n++) {
+                if (g_led_strip[n].pixels != NULL) lite_led_strip_mark_palette(&g_led_strip[n], changed);
+            }
+        }
+        g_led_palette_dirty = false;
+    }
+
+    for (size_t n = 0; n < LED_STRIP_NUM; n++) {
+        strip = &g_led_strip[n];
+        frames[n] = strip->frame;
+        lens[n] = (size_t)strip->count * 3;
+        if (strip->dirty_hi == 0 || strip->write_cb == NULL) continue;
+
+        dst = &strip->frame[(size_t)strip->dirty_lo * 3];
+        for (size_t i = strip->dirty_lo; i < strip->dirty_hi; i++) {
+            src = g_led_palette_out[strip->pixels[i]];
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst += 3;
+        }
+        len = (size_t)(strip->truncate ? strip->dirty_hi : strip->count) * 3;
+        strip->dirty_hi = 0;
+        if (g_led_port_buf != NULL) {
+            if (len > port_len) port_len = len;
+            continue;
+        }
+        strip->write_cb(strip->frame, len);
+        g_led_stats.strip_bytes += len;
+    }
+
+    if (g_led_port_buf != NULL && port_len > 0) {
+        // lite_led_strip_port_init() and lite_led_strip_init() checked the size
+        len = lite_led_strip_encode(frames, lens, LED_STRIP_NUM, port_len, g_led_port_buf);
+        g_led_port_cb(g_led_port_buf, len);
+        g_led_stats.strip_bytes += len;
+    }
+}
+#endif
+
+/**
+ * @brief Reset an LED and attach its callback, without journaling
+ *
+ * @param id LED ID
+ * @param cb Callback for brightness setting
+ * @return int Error code
+ */
+static int lite_led_setup(uint8_t id, led_set_brt_f cb)
+{
+#if LED_TIMER_SCAN_ENABLE
+    lite_led_timer_wake(id);
+#endif
+#if LED_SCRIPT_ENABLE
+    lite_led_script_release(&g_led_list[id]);
+#endif
+#if LED_OUT_LUT_ENABLE
+    lite_led_out_prepare();
+#endif
+#if LED_MOD_ENABLE
+    lite_led_mod_prepare();
+#endif
+#if LED_OUTPUT_INTERP_ENABLE
+    memset(&g_led_interp[id], 0, sizeof(g_led_interp[id]));
+#endif
+    memset(&g_led_list[id], 0, sizeof(led_dev_t));
+    g_led_list[id].id = id;
+    g_led_list[id].set_percent_cb = cb;
+#if LED_GOV_ENABLE
+    g_led_list[id].gov_tick = g_led_tick - 1;
+#if LED_CLOCK_ENABLE
+    g_led_list[id].gov_time_q16 = lite_led_clock_base_q16(LED_CLOCK_SYSTEM);
+#endif
+#endif
+#if LED_SCENE_ENABLE
+    g_led_morph_on[id] = false;
+    g_led_scene_seen[id] = g_led_scene_gen;
+#endif
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Initialize an LED instance
+ * 
+ * @param id LED ID (0 ~ LED_NUM-1)
+ * @param cb Callback for brightness setting (0-100%)
+ * @return int Error code (0: success, <0: failure)
+ */
+int lite_led_init(uint8_t id, led_set_brt_f cb)
+{
+    if (id >= LED_NUM || cb == NULL) return -1;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_INIT, id, 0);
+#endif
+
+    return lite_led_setup(id, cb);
+}
+
+/**
+ * @brief Turn a configuration into the form the poll runs
+ *
+ * @param id LED the configuration is for
+ * @param cfg LED configuration
+ * @param out Normalized configuration
+ * @return int Error code
+ */
+static int lite_led_cfg_normalize(uint8_t id, const led_cfg_t *cfg, led_inner_cfg_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->mode = cfg->mode;
+    out->alter_id = cfg->alter_id;
+    out->on_tick = cfg->on_ms / LED_POLL_PERIOD_MS;
+    out->off_tick = cfg->off_ms / LED_POLL_PERIOD_MS;
+    out->fade_tick = cfg->fade_ms / LED_POLL_PERIOD_MS;
+    out->alternate_tick = cfg->alternate_ms / LED_POLL_PERIOD_MS;
+    out->duration_tick = cfg->duration_ms / LED_POLL_PERIOD_MS;
+    out->script = cfg->script;
+    out->track = cfg->track;
+    out->offset_ms = cfg->offset_ms;
+
+    switch (cfg->mode) {
+        case LED_MODE_ON:
+            break;
+        case LED_MODE_OFF:
+            break;
+        case LED_MODE_BLINK:
+            break;
+        case LED_MODE_BREATH:
+        case LED_MODE_FADE_IN:
+        case LED_MODE_FADE_OUT:
+            // Phase step controls brightness update speed
+            out->phase_step = (float)LED_PI * LED_POLL_PERIOD_MS / (float)cfg->fade_ms;
+            if (out->phase_step <= 0.0f) {
+                out->phase_step = (float)LED_PI / (float)LED_MAX_BRIGHTNESS;
+            }
+            if (cfg->mode == LED_MODE_FADE_OUT) out->phase_step = -out->phase_step;
+            break;
+        case LED_MODE_ALTERNATE:
+            if (id == cfg->alter_id) return LED_ERROR_ALTERNATE_ID;
+            break;
+#if LED_SCRIPT_ENABLE
+        case LED_MODE_SCRIPT:
+            if (cfg->script == NULL || cfg->script->steps == NULL) return LED_ERROR_PARA_INVALID;
+            break;
+#endif
+#if LED_TRACK_ENABLE
+        case LED_MODE_TRACK:
+            if (cfg->track == NULL || cfg->track->keys == NULL || cfg->track->count == 0) {
+                return LED_ERROR_PARA_INVALID;
+            }
+            break;
+#endif
+        default:
+            return LED_ERROR_MODE_INVALID;
+    }
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Start the effect in the LED's normalized configuration
+ *
+ * @param led LED to start
+ * @return int Error code
+ */
+static int lite_led_start(led_dev_t *led)
+{
+#if LED_TIMER_SCAN_ENABLE
+    lite_led_timer_wake(led->id);
+#endif
+#if LED_SCRIPT_ENABLE
+    lite_led_script_release(led);
+#endif
+#if LED_SCENE_ENABLE
+    g_led_morph_on[led->id] = false;
+    g_led_scene_seen[led->id] = g_led_scene_gen;
+#endif
+    memset(&(led->stat), 0, sizeof(led->stat));
+    led->stat.remain_tick = led->cfg.duration_tick;
+    led->stat.phase_step = led->cfg.phase_step;
+#if LED_PULL_ENABLE
+    led->pull_start_q16 = lite_led_now_q16(led);
+#endif
+#if LED_GOV_ENABLE
+    // Count polls from the write, unless the LED already ran in this one
+    if (led->gov_tick != g_led_tick) {
+        led->gov_tick = g_led_tick - 1;
+#if LED_CLOCK_ENABLE
+        led->gov_time_q16 = lite_led_clock_base_q16(led->clock);
+#endif
+    }
+#endif
+
+    switch (led->cfg.mode) {
+        case LED_MODE_FADE_OUT:
+            led->stat.percent = LED_MAX_BRIGHTNESS;
+            led->stat.phase = LED_PI;
+            break;
+#if LED_SCRIPT_ENABLE
+        case LED_MODE_SCRIPT:
+            led->frame = lite_led_script_alloc();
+            if (led->frame == NULL) return LED_ERROR_NO_MEMORY;
+            memset(led->frame, 0, sizeof(*led->frame));
+            led->frame->script = led->cfg.script;
+            break;
+#endif
+#if LED_TRACK_ENABLE
+        case LED_MODE_TRACK:
+            led->stat.track_ms = led->cfg.offset_ms;
+            break;
+#endif
+        default:
+            break;
+    }
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Configure LED behavior
+ *
+ * An invalid configuration is rejected before the LED is touched.
+ *
+ * @param id LED ID
+ * @param cfg LED configuration
+ * @return int Error code
+ */
+int lite_led_write(uint8_t id, const led_cfg_t *cfg)
+{
+    led_inner_cfg_t inner;
+    int err;
+#if LED_JOURNAL_ENABLE
+    led_journal_rec_t *rec;
+#endif
+
+    if (id >= LED_MAX || cfg == NULL) return LED_ERROR_PARA_INVALID;
+
+    err = lite_led_cfg_normalize(id, cfg, &inner);
+    if (err != LED_ERROR_NONE) return err;
+
+#if LED_JOURNAL_ENABLE
+    // Only calls that take effect are logged
+    if (cfg->mode == LED_MODE_SCRIPT || cfg->mode == LED_MODE_TRACK) {
+        // The step list or keyframes are behind a pointer
+        lite_led_journal_unsupported(LED_JOURNAL_WRITE, id);
+    } else if ((rec = lite_led_journal_add(LED_JOURNAL_WRITE, id, cfg->on_ms)) != NULL) {
+        rec->mode = (uint8_t)cfg->mode;
+        rec->alter_id = (uint8_t)cfg->alter_id;
+        rec->arg[1] = cfg->off_ms;
+        rec->arg[2] = cfg->fade_ms;
+        rec->arg[3] = cfg->alternate_ms;
+        rec->arg[4] = cfg->duration_ms;
+        rec->arg[5] = cfg->offset_ms;
+    }
+#endif
+
+    g_led_list[id].cfg = inner;
+
+    return lite_led_start(&g_led_list[id]);
+}
+
+#if LED_EVENT_ENABLE
+/**
+ * @brief Bind an event to an effect
+ *
+ * The configuration is copied; scripts and tracks it points to must stay
+ * valid while bound. Rebinding an event replaces the previous binding.
+ *
+ * @param event Event ID (0 ~ LED_EVENT_NUM-1), e.g. a lite_button event
+ * @param led_mask LEDs to apply the effect to (bit n = LED n)
+ * @param cfg LED configuration
+ * @return int Error code
+ */
+int lite_led_event_bind(uint16_t event, uint32_t led_mask, const led_cfg_t *cfg)
+{
+    if (event >= LED_EVENT_NUM || cfg == NULL) return LED_ERROR_PARA_INVALID;
+    if (led_mask == 0 || (LED_NUM < 32 && (led_mask >> LED_NUM) != 0)) return LED_ERROR_PARA_INVALID;
+
+    g_led_event_table[event].cfg = *cfg;
+    g_led_event_table[event].led_mask = led_mask;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Remove an event binding
+ *
+ * @param event Event ID
+ * @return int Error code
+ */
+int lite_led_event_unbind(uint16_t event)
+{
+    if (event >= LED_EVENT_NUM) return LED_ERROR_PARA_INVALID;
+
+    g_led_event_table[event].led_mask = 0;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Dispatch an event to its bound effect
+ *
+ * Direct table lookup by event ID; the effect is written immediately and
+ * shows up on the very next poll. Call it straight from the event source,
+ * e.g. the lite_button event callback.
+ *
+ * @param event Event ID
+ * @return int Error code (LED_ERROR_NONE also for unbound events)
+ */
+int lite_led_event_post(uint16_t event)
+{
+    const led_binding_t *bind;
+    int ret = LED_ERROR_NONE;
+    int err;
+
+    if (event >= LED_EVENT_NUM) return LED_ERROR_PARA_INVALID;
+
+    bind = &g_led_event_table[event];
+    for (uint8_t id = 0; id < LED_NUM && (bind->led_mask >> id) != 0; id++) {
+        if ((bind->led_mask & (1u << id)) == 0) continue;
+        err = lite_led_write(id, &bind->cfg);
+        if (err != LED_ERROR_NONE && ret == LED_ERROR_NONE) ret = err;
+    }
+
+    return ret;
+}
+#endif
+
+#if LED_SCENE_ENABLE
+/**
+ * @brief Set the effect of one LED in a scene
+ *
+ * The configuration is checked and normalized here, so recalling the scene
+ * only copies it. Scripts and tracks it points to must stay valid while
+ * the scene is in use.
+ *
+ * @param scene Scene to fill
+ * @param id LED ID
+ * @param cfg LED configuration, NULL to leave the LED out of the scene
+ * @return int Error code
+ */
+int lite_led_scene_set(led_scene_t *scene, uint8_t id, const led_cfg_t *cfg)
+{
+    int err;
+
+    if (scene == NULL || id >= LED_NUM) return LED_ERROR_PARA_INVALID;
+
+    scene->used[id] = false;
+    if (cfg == NULL) return LED_ERROR_NONE;
+
+    err = lite_led_cfg_normalize(id, cfg, &scene->cfg[id]);
+    if (err != LED_ERROR_NONE) return err;
+    scene->used[id] = true;
+
+    return LED_ERROR_NONE;
+}
+
+#if LED_JOURNAL_ENABLE
+/**
+ * @brief Journal a scene recall followed by the scene's entries
+ */
+static void lite_led_journal_scene(const led_scene_t *scene, uint32_t morph_ms)
+{
+    const led_inner_cfg_t *cfg;
+    led_journal_rec_t *rec;
+
+    if (g_led_journal == NULL) return;
+
+    lite_led_journal_add(LED_JOURNAL_SCENE_RECALL, 0, morph_ms);
+    for (uint8_t id = 0; id < LED_NUM; id++) {
+        if (!scene->used[id]) continue;
+        cfg = &scene->cfg[id];
+        if (cfg->mode == LED_MODE_SCRIPT || cfg->mode == LED_MODE_TRACK) {
+            lite_led_journal_unsupported(LED_JOURNAL_SCENE_LED, id);
+            continue;
+        }
+        rec = lite_led_journal_add(LED_JOURNAL_SCENE_LED, id, (uint32_t)cfg->on_tick);
+        if (rec == NULL) continue;
+        rec->mode = (uint8_t)cfg->mode;
+        rec->alter_id = (uint8_t)cfg->alter_id;
+        rec->arg[1] = (uint32_t)cfg->off_tick;
+        rec->arg[2] = (uint32_t)cfg->fade_tick;
+        rec->arg[3] = (uint32_t)cfg->alternate_tick;
+        rec->arg[4] = (uint32_t)cfg->duration_tick;
+        memcpy(&rec->arg[5], &cfg->phase_step, sizeof(rec->arg[5]));
+    }
+}
+#endif
+
+/**
+ * @brief Switch the installation to a scene
+ *
+ * O(1): only the scene pointer is stored and swapped in at the next poll.
+ * Each LED of the scene copies its prebuilt effect at its next update and
+ * fades over morph_ms from the level it last output, mid-morph included;
+ * a morph costs one blend per LED per poll and nothing after it ends.
+ * Writing an LED directly stops its morph.
+ *
+ * @param scene Scene to apply, must stay valid while it is in use
+ * @param morph_ms Morph time in milliseconds (0 = switch at once)
+ * @return int Error code
+ */
+int lite_led_scene_recall(const led_scene_t *scene, uint32_t morph_ms)
+{
+    if (scene == NULL) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_scene(scene, morph_ms);
+#endif
+    g_led_scene = scene;
+    g_led_morph_pending = morph_ms / LED_POLL_PERIOD_MS;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Capture the effect of every initialized LED into a scene
+ *
+ * Captured effects restart from their beginning when recalled.
+ *
+ * @param scene Scene to fill
+ * @return int Error code
+ */
+int lite_led_scene_capture(led_scene_t *scene)
+{
+    const led_dev_t *led;
+
+    if (scene == NULL) return LED_ERROR_PARA_INVALID;
+
+    for (size_t i = 0; i < LED_NUM; i++) {
+        led = &g_led_list[i];
+        scene->used[i] = (led->set_percent_cb != NULL);
+        scene->cfg[i] = led->cfg;
+    }
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Swap in a recalled scene and advance the morph
+ *
+ * Runs in the poll before the LEDs are updated, so parallel workers never
+ * see a half-swapped scene. The LEDs copy their effects themselves.
+ */
+static void lite_led_scene_advance(void)
+{
+    if (g_led_scene != NULL) {
+        g_led_scene_live = g_led_scene;
+        g_led_scene = NULL;
+        g_led_scene_gen++;
+        g_led_morph_cut = (g_led_morph_total != 0);
+        g_led_morph_total = g_led_morph_pending;
+        g_led_morph_tick = 0;
+    }
+
+    if (g_led_morph_total == 0) return;
+    if (g_led_morph_tick == g_led_morph_total) {
+        g_led_morph_total = 0;
+        return;
+    }
+    g_led_morph_tick++;
+    g_led_morph_q8 = (uint16_t)(((uint64_t)g_led_morph_tick << 8) / g_led_morph_total);
+}
+
+/**
+ * @brief Check whether an LED is morphing into a scene this poll
+ */
+static bool lite_led_is_morphing(const led_dev_t *led)
+{
+    return (g_led_morph_total != 0) && g_led_morph_on[led->id];
+}
+
+/**
+ * @brief Copy the LED's effect from a newly loaded scene
+ *
+ * Called by the LED's own update, so the scene costs nothing in the poll
+ * that loads it. A parallel poll loads every LED in lite_led_poll_begin().
+ */
+static void lite_led_scene_load(led_dev_t *led)
+{
+    uint8_t id = led->id;
+    uint32_t seen = g_led_scene_seen[id];
+
+    if (seen == g_led_scene_gen) return;
+    g_led_scene_seen[id] = g_led_scene_gen;
+    if (!g_led_scene_live->used[id]) {
+        // Left out of the scene: the effect runs on, and a morph the load
+        // cut short glides on from where it got to. A morphing LED runs
+        // every poll, so one that missed a load was not morphing.
+        if (g_led_morph_cut && seen + 1 == g_led_scene_gen) {
+            g_led_morph_from[id] = g_led_morph_level[id];
+        } else {
+            g_led_morph_on[id] = false;
+        }
+        return;
+    }
+
+#if LED_PULL_ENABLE
+    // A pulled LED outputs nothing by itself: morph from where it is now
+    if (lite_led_is_lazy(led)) g_led_morph_level[id] = lite_led_eval(led);
+#endif
+    led->cfg = g_led_scene_live->cfg[id];
+    if (lite_led_start(led) != LED_ERROR_NONE) return;
+    g_led_morph_from[id] = g_led_morph_level[id];
+    g_led_morph_on[id] = (g_led_morph_total != 0);
+}
+#endif
+
+#if LED_SCHED_ENABLE
+/**
+ * @brief Run one schedule entry if it applies to the given weekday
+ */
+static void lite_led_sched_run(const led_sched_entry_t *e, uint8_t wday)
+{
+    if (e->days != 0 && ((e->days >> wday) & 1u) == 0) return;
+
+    switch (e->action) {
+#if LED_SCENE_ENABLE
+        case LED_SCHED_SCENE:
+            lite_led_scene_recall(e->scene, e->ms);
+            break;
+#endif
+#if LED_MASTER_ENABLE
+        case LED_SCHED_MASTER:
+            lite_led_set_master(e->percent);
+            break;
+#endif
+        case LED_SCHED_WRITE:
+            lite_led_write(e->id, e->cfg);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Point the cursor at the first entry after a time of day
+ */
+static void lite_led_sched_seek(uint32_t ms)
+{
+    uint16_t lo = 0;
+    uint16_t hi = g_led_sched_num;
+    uint16_t mid;
+
+    while (lo < hi) {
+        mid = (uint16_t)((lo + hi) / 2);
+        if (g_led_sched[mid].time_s * 1000u <= ms) lo = (uint16_t)(mid + 1);
+        else hi = mid;
+    }
+    g_led_sched_next = lo;
+    g_led_sched_due_ms = (lo < g_led_sched_num) ? g_led_sched[lo].time_s * 1000u : LED_DAY_MS;
+}
+
+/**
+ * @brief Move the schedule time forward, running every entry passed
+ */
+static void lite_led_sched_advance(uint32_t ms)
+{
+    g_led_sched_ms += ms;
+    while (g_led_sched_ms >= g_led_sched_due_ms) {
+        if (g_led_sched_due_ms == LED_DAY_MS) {
+            // Midnight: the next day starts from the first entry
+            g_led_sched_ms -= LED_DAY_MS;
+            g_led_sched_wday = (uint8_t)((g_led_sched_wday + 1) % 7);
+            g_led_sched_next = 0;
+        } else {
+            lite_led_sched_run(&g_led_sched[g_led_sched_next], g_led_sched_wday);
+            g_led_sched_next++;
+        }
+        g_led_sched_due_ms = (g_led_sched_next < g_led_sched_num) ?
+                             g_led_sched[g_led_sched_next].time_s * 1000u : LED_DAY_MS;
+    }
+}
+
+/**
+ * @brief Load a schedule
+ *
+ * Entries are sorted by time_s and must stay valid while loaded. Nothing
+ * runs on load; set the time with lite_led_sched_set_time() to bring the
+ * installation to the state the schedule defines for now.
+ *
+ * @param entries Schedule table, NULL to clear
+ * @param count Number of entries
+ * @return int Error code
+ */
+int lite_led_sched_load(const led_sched_entry_t *entries, uint16_t count)
+{
+    if (entries == NULL && count != 0) return LED_ERROR_PARA_INVALID;
+
+    for (uint16_t i = 0; i < count; i++) {
+        if (entries[i].time_s >= LED_DAY_MS / 1000u) return LED_ERROR_PARA_INVALID;
+        if (i > 0 && entries[i].time_s < entries[i - 1].time_s) return LED_ERROR_PARA_INVALID;
+        switch (entries[i].action) {
+#if LED_SCENE_ENABLE
+            case LED_SCHED_SCENE:
+                if (entries[i].scene == NULL) return LED_ERROR_PARA_INVALID;
+                break;
+#endif
+#if LED_MASTER_ENABLE
+            case LED_SCHED_MASTER:
+                if (entries[i].percent > LED_MAX_BRIGHTNESS) return LED_ERROR_PARA_INVALID;
+                break;
+#endif
+            case LED_SCHED_WRITE:
+                if (entries[i].id >= LED_NUM || entries[i].cfg == NULL) return LED_ERROR_PARA_INVALID;
+                break;
+            default:
+                return LED_ERROR_PARA_INVALID;
+        }
+    }
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_SCHED_LOAD, 0, count);
+#endif
+
+    g_led_sched = entries;
+    g_led_sched_num = count;
+    lite_led_sched_seek(g_led_sched_ms);
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Set the wall-clock time of the schedule
+ *
+ * Call at startup and whenever the RTC or network time is corrected.
+ * A forward step of up to LED_SCHED_CATCHUP_S runs the skipped entries in
+ * order. Any other step replays the last 24 hours of the schedule up to the
+ * new time, so the latest action of each kind wins.
+ *
+ * @param weekday Day of week (0 = Sunday)
+ * @param sec Seconds since midnight
+ * @return int Error code
+ */
+int lite_led_sched_set_time(uint8_t weekday, uint32_t sec)
+{
+    const uint32_t week_ms = 7u * LED_DAY_MS;
+    uint32_t now_pos, new_pos, ahead;
+    uint8_t yesterday;
+
+    if (weekday >= 7 || sec >= LED_DAY_MS / 1000u) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_SCHED_TIME, weekday, sec);
+#endif
+
+    now_pos = g_led_sched_wday * LED_DAY_MS + g_led_sched_ms;
+    new_pos = weekday * LED_DAY_MS + sec * 1000u;
+    ahead = (new_pos + week_ms - now_pos) % week_ms;
+
+    if (ahead <= LED_SCHED_CATCHUP_S * 1000u) {
+        lite_led_sched_advance(ahead);
+        return LED_ERROR_NONE;
+    }
+
+    g_led_sched_wday = weekday;
+    g_led_sched_ms = sec * 1000u;
+    lite_led_sched_seek(g_led_sched_ms);
+
+    // Entries after now ran yesterday, the ones up to now ran today
+    yesterday = (uint8_t)((weekday + 6) % 7);
+    for (uint16_t i = g_led_sched_next; i < g_led_sched_num; i++) {
+        lite_led_sched_run(&g_led_sched[i], yesterday);
+    }
+    for (uint16_t i = 0; i < g_led_sched_next; i++) {
+        lite_led_sched_run(&g_led_sched[i], weekday);
+    }
+
+    return LED_ERROR_NONE;
+}
+#endif
+
+#if LED_PULL_ENABLE || LED_PARALLEL_ENABLE
+/**
+ * @brief Check whether an LED is an ALTERNATE follower
+ *
+ * A follower copies the inverted state of its leader, the lower ID of the
+ * pair, at each of its own edges.
+ */
+static bool lite_led_is_follower(const led_dev_t *led)
+{
+    return (led->cfg.mode == LED_MODE_ALTERNATE) &&
+           (led->cfg.alter_id < LED_NUM) &&
+           (led->cfg.alter_id < led->id);
+}
+#endif
+
+#if LED_PULL_ENABLE
+/**
+ * @brief Check whether the poll leaves an LED to lite_led_sample()
+ *
+ * Scripts have no closed form and keep running in the poll. So do ALTERNATE
+ * followers: what they show depends on the leader's state at their own
+ * edges, not on the current one.
+ */
+static bool lite_led_is_lazy(const led_dev_t *led)
+{
+    return led->pull && led->cfg.mode != LED_MODE_SCRIPT && !lite_led_is_follower(led);
+}
+
+/**
+ * @brief Evaluate an LED's effect in closed form at a clock time
+ *
+ * Gives the brightness the push path shows after the polls up to now_q16
+ * since lite_led_write(), up to float rounding of the phase.
+ */
+static uint8_t lite_led_eval_at(const led_dev_t *led, uint64_t now_q16)
+{
+    uint64_t elapsed_q16 = now_q16 - led->pull_start_q16;
+    // Whole ticks the push path would have run: count tick boundaries crossed
+    size_t elapsed = (size_t)((now_q16 >> 16) - (led->pull_start_q16 >> 16));
+    size_t on, off, period;
+    float phase;
+
+    if (!lite_led_is_lazy(led) || elapsed_q16 == 0) return led->stat.percent;
+    // Same end as lite_led_tick(): the tick that uses up the duration keeps
+    // the last level, the next one turns the LED off
+    if (led->cfg.duration_tick != 0 && elapsed >= led->cfg.duration_tick) {
+        if (!lite_led_is_phase_mode(led->cfg.mode)) {
+            // Ticks run one at a time
+            if (elapsed > led->cfg.duration_tick) return LED_MIN_BRIGHTNESS;
+            elapsed--;
+        } else {
+            // Curves take a poll's ticks at once: the level is the one from
+            // before the poll that used up the duration, until the next tick
+            now_q16 = lite_led_step_q16(led, now_q16);
+            if ((now_q16 >> 16) - (led->pull_start_q16 >> 16) >= led->cfg.duration_tick) {
+                return LED_MIN_BRIGHTNESS;
+            }
+            elapsed_q16 = now_q16 - led->pull_start_q16;
+            if (elapsed_q16 == 0) return led->stat.percent;
+        }
+    }
+
+    // A slow clock may not have ticked yet: nothing ran but the curves
+    if (elapsed == 0 && !lite_led_is_phase_mode(led->cfg.mode)) return led->stat.percent;
+
+    switch (led->cfg.mode) {
+        case LED_MODE_ON:
+            return LED_MAX_BRIGHTNESS;
+        case LED_MODE_BLINK:
+            on = led->cfg.on_tick ? led->cfg.on_tick : 1;
+            off = led->cfg.off_tick ? led->cfg.off_tick : 1;
+            return ((elapsed - 1) % (on + off) < on) ? LED_MAX_BRIGHTNESS : LED_MIN_BRIGHTNESS;
+        case LED_MODE_BREATH:
+        case LED_MODE_FADE_IN:
+        case LED_MODE_FADE_OUT:
+            phase = fabsf(led->stat.phase_step) * (float)elapsed_q16 / 65536.0f;
+            if (led->cfg.mode == LED_MODE_BREATH) {
+                phase = fmodf(phase, (float)LED_2PI);
+            } else if (led->cfg.mode == LED_MODE_FADE_IN) {
+                if (phase > LED_PI) phase = LED_PI;
+            } else {
+                phase = (phase > LED_PI) ? 0.0f : (float)LED_PI - phase;
+            }
+            return lite_led_curve(phase);
+        case LED_MODE_ALTERNATE:
+            // Only leaders get here, followers are not lazy
+            if (led->cfg.alter_id >= LED_NUM) return led->stat.percent;
+            period = led->cfg.alternate_tick ? led->cfg.alternate_tick : 1;
+            return (((elapsed - 1) / period) % 2 == 0) ? LED_MAX_BRIGHTNESS : LED_MIN_BRIGHTNESS;
+#if LED_TRACK_ENABLE
+        case LED_MODE_TRACK: {
+            uint16_t cursor = led->stat.track_key;
+            uint8_t percent;
+
+            // track_ms holds the start offset; poll n shows offset + (n-1) periods
+            percent = lite_led_track_sample(led->cfg.track, &cursor,
+                                            led->stat.track_ms + (uint32_t)(elapsed - 1) * LED_POLL_PERIOD_MS);
+            return percent;
+        }
+#endif
+        default:
+            return LED_MIN_BRIGHTNESS;
+    }
+}
+
+/**
+ * @brief Evaluate an LED's effect in closed form at the current time
+ */
+static uint8_t lite_led_eval(const led_dev_t *led)
+{
+    return lite_led_eval_at(led, lite_led_now_q16(led));
+}
+
+/**
+ * @brief State of an ALTERNATE leader as the poll in progress leaves it
+ *
+ * A pulled leader is not run by the poll, so its state is derived in
+ * closed form: OFF, ON, BLINK and ALTERNATE are on exactly when lit, the
+ * curve modes keep the state lite_led_write() reset.
+ */
+static led_state_e lite_led_eval_state(const led_dev_t *led)
+{
+    if (!lite_led_is_lazy(led)) return led->stat.state;
+
+    switch (led->cfg.mode) {
+        case LED_MODE_OFF:
+        case LED_MODE_ON:
+        case LED_MODE_BLINK:
+        case LED_MODE_ALTERNATE:
+            return (lite_led_eval_at(led, lite_led_poll_now_q16(led)) == LED_MAX_BRIGHTNESS) ?
+                   LED_STATE_ON : LED_STATE_OFF;
+        default:
+            return led->stat.state;
+    }
+}
+
+/**
+ * @brief Switch an LED between push and pull mode
+ *
+ * A pull LED is skipped by the poll and has no brightness callback
+ * traffic; its brightness is computed only when lite_led_sample() or
+ * lite_led_read() asks for it. Scripts and ALTERNATE followers have no
+ * closed form and keep running in the poll. Set this before
+ * lite_led_write(): turning pull off resumes the push state machine where
+ * it was left.
+ *
+ * @param id LED ID
+ * @param pull true: evaluate on demand, false: evaluate every poll
+ * @return int Error code
+ */
+int lite_led_set_pull(uint8_t id, bool pull)
+{
+    if (id >= LED_NUM) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_PULL, id, pull);
+#endif
+#if LED_TIMER_SCAN_ENABLE
+    lite_led_timer_wake(id);
+#endif
+    g_led_list[id].pull = pull;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Evaluate an LED's brightness now
+ *
+ * @param id LED ID
+ * @param percent Output brightness (0-100%)
+ * @return int Error code
+ */
+int lite_led_sample(uint8_t id, uint8_t *percent)
+{
+    if (id >= LED_NUM || percent == NULL) return LED_ERROR_PARA_INVALID;
+
+    *percent = lite_led_eval(&g_led_list[id]);
+
+    return LED_ERROR_NONE;
+}
+#endif
+
+/**
+ * @brief Read LED current status
+ *
+ * @param id LED ID
+ * @param status Output status
+ * @return int Error code
+ */
+int lite_led_read(uint8_t id, led_status_t *status)
+{
+    if (id >= LED_NUM || status == NULL) return LED_ERROR_PARA_INVALID;
+
+#if LED_TIMER_SCAN_ENABLE
+    lite_led_timer_sync(id);
+#endif
+    *status = g_led_list[id].stat;
+#if LED_PULL_ENABLE
+    status->percent = lite_led_eval(&g_led_list[id]);
+#endif
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Output stage: hand an LED's brightness to its backends
+ */
+static void lite_led_output(led_dev_t *led)
+{
+    uint8_t percent = led->stat.percent;
+    bool smooth = false;
+
+#if LED_SCENE_ENABLE
+    if (lite_led_is_morphing(led)) {
+        percent = (uint8_t)(g_led_morph_from[led->id] +
+                            (((int32_t)percent - g_led_morph_from[led->id]) * g_led_morph_q8) / 256);
+    }
+    g_led_morph_level[led->id] = percent;
+#endif
+#if LED_MOD_ENABLE
+    percent = (uint8_t)((percent * g_led_mod[led->id].level_q8 + 128u) >> 8);
+#endif
+#if LED_OUTPUT_INTERP_ENABLE
+    // Edges (ON/OFF/BLINK/ALTERNATE) must stay sharp, curves get smoothed
+    switch (led->cfg.mode) {
+        case LED_MODE_BREATH:
+        case LED_MODE_FADE_IN:
+        case LED_MODE_FADE_OUT:
+        case LED_MODE_SCRIPT:
+        case LED_MODE_TRACK:
+            smooth = true;
+            break;
+        default:
+            break;
+    }
+#if LED_GOV_ENABLE
+    if (g_led_stats.gov_level >= LED_GOV_NO_INTERP) smooth = false;
+#endif
+#endif
+#if LED_CCT_ENABLE
+    if (g_led_cct_of[led->id] != 0) {
+        lite_led_cct_output(&g_led_cct[g_led_cct_of[led->id] - 1], percent, smooth);
+        return;
+    }
+#endif
+    lite_led_emit(led, percent, smooth);
+}
+
+#if LED_OUTPUT_INTERP_ENABLE
+/**
+ * @brief Output-rate update between engine ticks
+ *
+ * Call every LED_OUTPUT_PERIOD_MS from the same context as the poll. Each
+ * LED with a pending key moves one linear step towards it; only changed
+ * values are sent, so settled LEDs cost a single compare.
+ */
+void lite_led_output_poll(void)
+{
+    led_interp_t *ip;
+    uint8_t percent;
+
+    for (size_t i = 0; i < LED_NUM; i++) {
+        ip = &g_led_interp[i];
+        if (ip->steps == 0) continue;
+
+        if (--ip->steps == 0) {
+            ip->level_q8 = (uint16_t)(ip->target << 8);
+        } else {
+            ip->level_q8 = (uint16_t)(ip->level_q8 + ip->step_q8);
+        }
+
+        percent = (uint8_t)((ip->level_q8 + 128u) >> 8);
+        if (percent == ip->sent || g_led_list[i].set_percent_cb == NULL) continue;
+        ip->sent = percent;
+        lite_led_send(&g_led_list[i], percent);
+    }
+}
+#endif
+
+/**
+ * @brief Check whether a mode is driven by a continuous phase
+ */
+static bool lite_led_is_phase_mode(led_mode_e mode)
+{
+    return (mode == LED_MODE_BREATH) || (mode == LED_MODE_FADE_IN) || (mode == LED_MODE_FADE_OUT);
+}
+
+#if LED_GOV_ENABLE
+/**
+ * @brief Set the time source the governor measures polls with
+ *
+ * The governor only runs with a timer: a poll's cost is the wall time it
+ * took, which the library has no portable way to read. Until one is set,
+ * or after it is cleared, every LED runs at full quality.
+ *
+ * @param now_us Free-running microsecond counter (e.g. a hardware timer or
+ *               CLOCK_MONOTONIC), NULL to stop the governor
+ * @return int Error code
+ */
+int lite_led_gov_set_timer(led_time_us_f now_us)
+{
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_unsupported(LED_JOURNAL_GOV_TIMER, 0);
+#endif
+    g_led_gov_now_us = now_us;
+    g_led_gov_cost_q4 = 0;
+    g_led_gov_hold = 0;
+    g_led_stats.poll_us = 0;
+    g_led_stats.load_percent = 0;
+    if (now_us == NULL && g_led_stats.gov_level != LED_GOV_FULL) {
+        g_led_stats.gov_level = LED_GOV_FULL;
+        g_led_stats.gov_changes++;
+#if LED_TIMER_SCAN_ENABLE
+        for (uint8_t id = 0; id < LED_NUM; id++) {
+            lite_led_timer_wake(id);
+        }
+#endif
+    }
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Mark an LED as low priority
+ *
+ * Low-priority LEDs are the first to be updated less often when the poll
+ * is overloaded (LED_GOV_DEFER_LOW).
+ *
+ * @param id LED ID
+ * @param low true for low priority
+ * @return int Error code
+ */
+int lite_led_set_priority(uint8_t id, bool low)
+{
+    if (id >= LED_NUM) return LED_ERROR_PARA_INVALID;
+
+#if LED_JOURNAL_ENABLE
+    lite_led_journal_add(LED_JOURNAL_PRIORITY, id, low);
+#endif
+    g_led_list[id].low_priority = low;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Polls between two updates of an LED at the current quality level
+ *
+ * LEDs are staggered by ID so a stride spreads their cost over the polls.
+ */
+static uint32_t lite_led_gov_stride(const led_dev_t *led)
+{
+    if (g_led_stats.gov_level >= LED_GOV_DEFER_LOW && led->low_priority) return 4;
+    if (g_led_stats.gov_level >= LED_GOV_SLOW_HALF && lite_led_is_phase_mode(led->cfg.mode)) return 2;
+    return 1;
+}
+
+/**
+ * @brief Average the cost of the finished poll and pick the quality level
+ *
+ * Quality drops one level when the average cost is above
+ * LED_GOV_HIGH_PERCENT of the period and comes back one level below
+ * LED_GOV_LOW_PERCENT, at most once per LED_GOV_HOLD_TICKS polls.
+ */
+static void lite_led_gov_step(void)
+{
+    const uint32_t period_us = LED_POLL_PERIOD_MS * 1000u;
+    uint32_t cost;
+    uint32_t avg;
+
+    if (g_led_gov_now_us == NULL) return;
+    cost = g_led_gov_now_us() - g_led_gov_start_us;
+
+    g_led_gov_cost_q4 = g_led_gov_cost_q4 - (g_led_gov_cost_q4 >> LED_GOV_EWMA_SHIFT) +
+                        ((cost << 4) >> LED_GOV_EWMA_SHIFT);
+    avg = g_led_gov_cost_q4 >> 4;
+    g_led_stats.poll_us = avg;
+    g_led_stats.load_percent = (uint8_t)((avg >= period_us) ? 100 : avg * 100u / period_us);
+
+    if (g_led_gov_hold != 0) {
+        g_led_gov_hold--;
+        return;
+    }
+    if (g_led_stats.load_percent > LED_GOV_HIGH_PERCENT && g_led_stats.gov_level + 1 < LED_GOV_LEVEL_MAX) {
+        g_led_stats.gov_level++;
+    } else if (g_led_stats.load_percent < LED_GOV_LOW_PERCENT && g_led_stats.gov_level > LED_GOV_FULL) {
+        g_led_stats.gov_level--;
+    } else {
+        return;
+    }
+    g_led_stats.gov_changes++;
+    g_led_gov_hold = LED_GOV_HOLD_TICKS;
+#if LED_TIMER_SCAN_ENABLE
+    for (uint8_t id = 0; id < LED_NUM; id++) {
+        lite_led_timer_wake(id);
+    }
+#endif
+}
+#endif
+
+/**
+ * @brief Run the LED state machine once
+ *
+ * Handles duration and tick countdown and runs the mode handling.
+ *
+ * @param led LED device
+ * @param elapsed Ticks counted against the duration
+ * @param scale Phase step multiplier for BREATH/FADE
+ * @return bool true if the mode handling ran (brightness must be pushed)
+ */
+static bool lite_led_tick(led_dev_t *led, size_t elapsed, float scale)
+{
+    // Duration handling
+    if (led->stat.remain_tick != 0 && elapsed != 0) {
+        if (led->stat.remain_tick <= elapsed) {
+            led->stat.remain_tick = 0;
+            led->cfg.mode = LED_MODE_OFF;
+            led->stat.next_tick = 0;
+#if LED_PULL_ENABLE
+            // A pulled follower turns lazy here and keeps its level for this poll
+            led->pull_start_q16 = lite_led_poll_now_q16(led);
+#endif
+            return false;
+        }
+        led->stat.remain_tick -= elapsed;
+    }
+
+    // Tick countdown
+    if (led->stat.next_tick == LED_BLOCK_FOREVER) return false;
+    if (led->stat.next_tick != 0) {
+        led->stat.next_tick--;
+        if (led->stat.next_tick != 0) return false;
+    }
+
+    // Mode handling
+    switch (led->cfg.mode) {
+        case LED_MODE_OFF:
+            led->stat.state = LED_STATE_OFF;
+            led->stat.percent = LED_MIN_BRIGHTNESS;
+            led->stat.next_tick = LED_BLOCK_FOREVER;
+            break;
+        case LED_MODE_ON:
+            led->stat.state = LED_STATE_ON;
+            led->stat.percent = LED_MAX_BRIGHTNESS;
+            led->stat.next_tick = LED_BLOCK_FOREVER;
+            break;
+        case LED_MODE_BLINK:
+            if (led->stat.state == LED_STATE_OFF) {
+                led->stat.next_tick = led->cfg.on_tick;
+                led->stat.percent = LED_MAX_BRIGHTNESS;
+            } else {
+                led->stat.next_tick = led->cfg.off_tick;
+                led->stat.percent = LED_MIN_BRIGHTNESS;
+            }
+            led->stat.state = !(led->stat.state);
+            break;
+        case LED_MODE_FADE_IN:
+        case LED_MODE_FADE_OUT:
+        case LED_MODE_BREATH:
+            led->stat.phase += led->stat.phase_step * scale; // Phase update
+            if (led->cfg.mode == LED_MODE_BREATH) {
+                if (led->stat.phase >= LED_2PI) led->stat.phase -= LED_2PI;
+            } else if (led->cfg.mode == LED_MODE_FADE_IN) {
+                if (led->stat.phase >= LED_PI) {
+                    led->stat.phase = LED_PI;
+                    led->stat.next_tick = LED_BLOCK_FOREVER;
+                }
+            } else if (led->cfg.mode == LED_MODE_FADE_OUT) {
+                if (led->stat.phase <= 0.0f) {
+                    led->stat.phase = 0.0f;
+                    led->stat.next_tick = LED_BLOCK_FOREVER;
+                }
+            }
+            // Brightness update (cosine wave)
+            led->stat.percent = lite_led_curve(led->stat.phase);
+            break;
+        case LED_MODE_ALTERNATE:
+            if (led->cfg.alter_id >= LED_NUM) break;
+            led->stat.next_tick = led->cfg.alternate_tick;
+            if (led->id < led->cfg.alter_id) {
+                led->stat.state = !(led->stat.state);
+                led->stat.percent = (led->stat.state == LED_STATE_ON) ? LED_MAX_BRIGHTNESS : LED_MIN_BRIGHTNESS;
+            } else {
+#if LED_PULL_ENABLE
+                led->stat.state = !lite_led_eval_state(&g_led_list[led->cfg.alter_id]);
+#else
+                led->stat.state = !(g_led_list[led->cfg.alter_id].stat.state);
+#endif
+                led->stat.percent = (led->stat.state == LED_STATE_ON) ? LED_MAX_BRIGHTNESS : LED_MIN_BRIGHTNESS;
+            }
+            break;
+#if LED_SCRIPT_ENABLE
+        case LED_MODE_SCRIPT:
+            lite_led_script_run(led);
+            break;
+#endif
+#if LED_TRACK_ENABLE
+        case LED_MODE_TRACK: {
+            uint32_t length = led->cfg.track->keys[led->cfg.track->count - 1].ms;
+
+            led->stat.percent = lite_led_track_sample(led->cfg.track, &led->stat.track_key, led->stat.track_ms);
+            led->stat.track_ms += LED_POLL_PERIOD_MS;
+            if (!led->cfg.track->loop) {
+                if (led->stat.track_ms > length) led->stat.next_tick = LED_BLOCK_FOREVER;
+            } else if (length != 0 && led->stat.track_ms >= length) {
+                led->stat.track_ms %= length;
+            }
+            break;
+        }
+#endif
+        default:
+            break;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Update one LED for the current poll
+ *
+ * Runs the state machine for the time its clock domain advanced and
+ * pushes the resulting brightness through the LED callback.
+ *
+ * @param led LED device
+ * @return uint8_t LED_UPDATE_* flags
+ */
+static uint8_t lite_led_update(led_dev_t *led)
+{
+    uint8_t prev_percent = led->stat.percent;
+    bool run = false;
+    float speed = 1.0f;
+    uint32_t polls = 1;
+#if LED_GOV_ENABLE
+    uint32_t stride;
+#endif
+
+    if (led->set_percent_cb == NULL) return 0;
+#if LED_SCENE_ENABLE
+    lite_led_scene_load(led);
+#endif
+#if LED_GOV_ENABLE
+    // Skipped polls are made up in one go on the LED's turn. Count the ones
+    // that really passed: after a quality change that is not the stride.
+    stride = lite_led_gov_stride(led);
+    if (stride > 1 && (g_led_tick + led->id) % stride != 0) return 0;
+    polls = g_led_tick - led->gov_tick;
+    led->gov_tick = g_led_tick;
+#endif
+#if LED_PULL_ENABLE
+    if (lite_led_is_lazy(led)) return 0;
+#endif
+#if LED_CCT_ENABLE
+    if (lite_led_cct_is_slave(led)) return 0;
+#endif
+
+#if LED_MOD_ENABLE
+    speed = g_led_mod[led->id].speed;
+#endif
+#if LED_CLOCK_ENABLE
+    const led_clock_t *clk = &g_led_clock[led->clock];
+    uint32_t steps = clk->steps * polls;
+    float scale = clk->scale * (float)polls;
+
+#if LED_GOV_ENABLE
+    // Catch up by the domain time that passed since the LED last ran: a
+    // domain at 1.5x steps 1, 2, 1, 2... and its rate may have changed
+    if (polls != 1) {
+        steps = (uint32_t)((clk->time_q16 >> 16) - (led->gov_time_q16 >> 16));
+        scale = (float)(clk->time_q16 - led->gov_time_q16) / 65536.0f;
+    }
+    led->gov_time_q16 = clk->time_q16;
+#endif
+    if (lite_led_is_phase_mode(led->cfg.mode)) {
+        // Continuous phase: one scaled step per poll, no judder at odd rates
+        run = lite_led_tick(led, steps, scale * speed);
+    } else {
+        for (uint32_t i = 0; i < steps; i++) {
+            if (lite_led_tick(led, 1, 1.0f)) run = true;
+        }
+    }
+#else
+    if (polls > 1 && !lite_led_is_phase_mode(led->cfg.mode)) {
+        for (uint32_t i = 0; i < polls; i++) {
+            if (lite_led_tick(led, 1, 1.0f)) run = true;
+        }
+    } else {
+        run = lite_led_tick(led, polls, speed * (float)polls);
+    }
+#endif
+#if LED_CCT_ENABLE
+    if (lite_led_cct_step(led)) run = true;
+#endif
+#if LED_SCENE_ENABLE
+    if (lite_led_is_morphing(led)) run = true;
+#endif
+#if LED_MOD_ENABLE
+    // A modulated level changes the output even when the effect is parked
+    if (g_led_mod[led->id].level_routed || g_led_mod[led->id].refresh) run = true;
+    g_led_mod[led->id].refresh = false;
+#endif
+    if (!run) return 0;
+
+    // Update brightness
+    lite_led_output(led);
+
+    if (led->stat.percent != prev_percent) return LED_UPDATE_PUSHED | LED_UPDATE_CHANGED;
+    return LED_UPDATE_PUSHED;
+}
+
+#if LED_TIMER_SCAN_ENABLE
+/**
+ * @brief Count every LED's wait down and flag the LEDs due in this poll
+ *
+ * Branch-free over contiguous arrays so that the compiler vectorizes it;
+ * the due flags are the byte mask the poll then walks.
+ */
+static void lite_led_timer_scan(void)
+{
+#if LED_CLOCK_ENABLE
+    // A parked LED counts polls as ticks of a real-time domain; once the
+    // domain's rate has changed, the LEDs on it go back to ticking
+    for (size_t clk = 0; clk < LED_CLOCK_MAX; clk++) {
+        if (g_led_wait_clock_gen[clk] == g_led_clock[clk].gen) continue;
+        g_led_wait_clock_gen[clk] = g_led_clock[clk].gen;
+        for (uint8_t id = 0; id < LED_NUM; id++) {
+            if (g_led_list[id].clock == clk) lite_led_timer_wake(id);
+        }
+    }
+#endif
+#if LED_SCENE_ENABLE
+    // The LEDs of a newly loaded scene pick it up at their next update
+    if (g_led_wait_scene_gen != g_led_scene_gen) {
+        g_led_wait_scene_gen = g_led_scene_gen;
+        for (uint8_t id = 0; id < LED_NUM; id++) {
+            if (g_led_scene_live->used[id]) lite_led_timer_wake(id);
+        }
+    }
+#endif
+    for (size_t i = 0; i < LED_NUM; i++) {
+        uint32_t wait = g_led_wait[i];
+
+        g_led_due[i] = (uint8_t)(wait == 0);
+        g_led_wait[i] = wait - (wait != 0);
+    }
+}
+
+/**
+ * @brief Whether nothing but the LED's two timers can change its output
+ */
+static bool lite_led_timer_can_park(const led_dev_t *led)
+{
+    if (led->set_percent_cb == NULL) return false;
+#if LED_PULL_ENABLE
+    if (lite_led_is_lazy(led)) return false;
+#endif
+#if LED_CCT_ENABLE
+    if (g_led_cct_of[led->id] != 0) return false;
+#endif
+#if LED_CLOCK_ENABLE
+    // Other rates step the timers by 0, 1 or more ticks per poll
+    if (g_led_clock[led->clock].rate_q16 != 1u << 16) return false;
+#endif
+#if LED_SYNC_ENABLE
+    if (g_led_stats.sync_locked) return false;
+#endif
+#if LED_MOD_ENABLE
+    if (g_led_mod[led->id].level_routed) return false;
+#endif
+#if LED_SCENE_ENABLE
+    if (lite_led_is_morphing(led)) return false;
+#endif
+#if LED_GOV_ENABLE
+    if (g_led_stats.gov_level != LED_GOV_FULL) return false;
+#endif
+    return true;
+}
+
+/**
+ * @brief Skip the LED up to the poll of its next edge or duration end
+ */
+static void lite_led_timer_park(uint8_t id)
+{
+    const led_dev_t *led = &g_led_list[id];
+    size_t wait = 0;
+
+    if (led->stat.next_tick != 0 && lite_led_timer_can_park(led)) {
+        wait = (led->stat.next_tick == LED_BLOCK_FOREVER) ? UINT32_MAX : led->stat.next_tick - 1;
+        if (led->stat.remain_tick != 0 && led->stat.remain_tick - 1 < wait) wait = led->stat.remain_tick - 1;
+    }
+    g_led_wait[id] = (uint32_t)wait;
+    g_led_wait_set[id] = (uint32_t)wait;
+}
+#endif
+
+/**
+ * @brief First LED at or after `from` to update in this poll
+ *
+ * Steps over eight due flags at a time while none of them is set.
+ */
+static size_t lite_led_next_due(size_t from)
+{
+#if LED_TIMER_SCAN_ENABLE
+    uint64_t flags;
+
+    while (from < LED_NUM) {
+        memcpy(&flags, &g_led_due[from], sizeof(flags));
+        if (flags != 0) break;
+        from += sizeof(flags);
+    }
+    while (from < LED_NUM && !g_led_due[from]) from++;
+#endif
+    return from;
+}
+
+/**
+ * @brief Update one LED in the poll
+ *
+ * @return uint8_t LED_UPDATE_* flags
+ */
+static uint8_t lite_led_poll_one(uint8_t id)
+{
+#if LED_TIMER_SCAN_ENABLE
+    uint8_t flags;
+
+    if (!g_led_due[id]) return 0;
+    lite_led_timer_sync(id);
+    flags = lite_led_update(&g_led_list[id]);
+    lite_led_timer_park(id);
+
+    return flags;
+#else
+    return lite_led_update(&g_led_list[id]);
+#endif
+}
+
+/**
+ * @brief Add the result of one LED update to the statistics
+ *
+ * @param flags LED_UPDATE_* flags returned by lite_led_update()
+ */
+static void lite_led_account(uint8_t flags)
+{
+    if (flags & LED_UPDATE_PUSHED) g_led_stats.update_count++;
+    if (flags & LED_UPDATE_CHANGED) g_led_stats.change_count++;
+}
+
+/**
+ * @brief Per-poll work that is not per LED
+ *
+ * Runs once before the LEDs are updated.
+ */
+static void lite_led_poll_prepare(void)
+{
+#if LED_GOV_ENABLE
+    if (g_led_gov_now_us != NULL) g_led_gov_start_us = g_led_gov_now_us();
+#endif
+#if LED_SCHED_ENABLE
+    lite_led_sched_advance(LED_POLL_PERIOD_MS);
+#endif
+#if LED_SCENE_ENABLE
+    lite_led_scene_advance();
+#endif
+#if LED_CLOCK_ENABLE
+    lite_led_clock_advance();
+#endif
+#if LED_MOD_ENABLE
+    lite_led_mod_advance();
+#endif
+#if LED_THERMAL_ENABLE
+    if (g_led_tick % LED_THERMAL_PERIOD_TICKS == 0) lite_led_thermal_step();
+#endif
+#if LED_TIMER_SCAN_ENABLE
+    lite_led_timer_scan();
+#endif
+}
+
+/**
+ * @brief Per-poll work after every LED is updated
+ */
+static void lite_led_poll_finish(void)
+{
+#if LED_STRIP_ENABLE
+    lite_led_strip_flush();
+#endif
+#if LED_GOV_ENABLE
+    lite_led_gov_step();
+#endif
+    g_led_tick++;
+}
+
+#if LED_PARALLEL_ENABLE
+/**
+ * @brief Start a parallel poll round
+ *
+ * Must be called by one thread before any worker calls lite_led_poll_work().
+ */
+void lite_led_poll_begin(void)
+{
+#if LED_SCENE_ENABLE
+    uint32_t gen = g_led_scene_gen;
+#endif
+
+    lite_led_poll_prepare();
+#if LED_SCENE_ENABLE
+    // A scene may turn LEDs into followers, which lite_led_poll_work() has
+    // to tell apart by their effect: load it before any chunk is claimed
+    if (gen != g_led_scene_gen) {
+        for (size_t i = 0; i < LED_NUM; i++) {
+            if (g_led_list[i].set_percent_cb != NULL) lite_led_scene_load(&g_led_list[i]);
+        }
+    }
+#endif
+    atomic_store(&g_led_chunk_next, 0);
+}
+
+/**
+ * @brief Claim and update the next unprocessed chunk of LEDs
+ *
+ * Workers keep calling this until it returns false. Chunks are handed out
+ * from a shared cursor, so a worker that drew cheap LEDs simply claims
+ * more chunks while another is still busy with expensive ones.
+ *
+ * @return true if a chunk was processed, false if none are left
+ */
+bool lite_led_poll_work(void)
+{
+    size_t start = atomic_fetch_add(&g_led_chunk_next, LED_PARALLEL_CHUNK);
+    size_t end = start + LED_PARALLEL_CHUNK;
+    unsigned int updates = 0;
+    unsigned int changes = 0;
+    uint8_t flags;
+
+    if (start >= LED_NUM) return false;
+    if (end > LED_NUM) end = LED_NUM;
+
+    for (size_t i = lite_led_next_due(start); i < end; i = lite_led_next_due(i + 1)) {
+        // A follower reads its leader's state of this poll, which another
+        // chunk may be writing: lite_led_poll_end() runs it
+        if (lite_led_is_follower(&g_led_list[i])) continue;
+        flags = lite_led_poll_one((uint8_t)i);
+        if (flags & LED_UPDATE_PUSHED) updates++;
+        if (flags & LED_UPDATE_CHANGED) changes++;
+    }
+
+    // One atomic add per chunk keeps workers off a shared counter
+    if (updates) atomic_fetch_add(&g_led_par_updates, updates);
+    if (changes) atomic_fetch_add(&g_led_par_changes, changes);
+
+    return true;
+}
+
+/**
+ * @brief Finish a parallel poll round
+ *
+ * Must be called by one thread after every worker has returned false from
+ * lite_led_poll_work(). Updates the LEDs that were deferred.
+ */
+void lite_led_poll_end(void)
+{
+    for (size_t i = 0; i < LED_NUM; i++) {
+        if (lite_led_is_follower(&g_led_list[i])) {
+            lite_led_account(lite_led_poll_one((uint8_t)i));
+        }
+    }
+
+    g_led_stats.update_count += atomic_exchange(&g_led_par_updates, 0);
+    g_led_stats.change_count += atomic_exchange(&g_led_par_changes, 0);
+    lite_led_poll_finish();
+}
+#endif
+
+/**
+ * @brief Periodic LED state update
+ *
+ * This function should be called every LED_POLL_PERIOD_MS.
+ * It updates LED states, handles timers, and triggers brightness callbacks.
+ */
+void lite_led_poll_handle(void)
+{
+#if LED_PARALLEL_ENABLE
+    lite_led_poll_begin();
+    while (lite_led_poll_work()) {}
+    lite_led_poll_end();
+#else
+    lite_led_poll_prepare();
+    for (size_t i = lite_led_next_due(0); i < LED_NUM; i = lite_led_next_due(i + 1)) {
+        lite_led_account(lite_led_poll_one((uint8_t)i));
+    }
+    lite_led_poll_finish();
+#endif
+}
+
+/**
+ * @brief Read engine statistics
+ *
+ * @param stats Output statistics
+ * @return int Error code
+ */
+int lite_led_get_stats(led_stats_t *stats)
+{
+    if (stats == NULL) return LED_ERROR_PARA_INVALID;
+
+    *stats = g_led_stats;
+    stats->tick = g_led_tick;
+#if LED_AUTOTUNE_ENABLE
+    stats->curve_kernel = g_led_curve_kernel;
+#endif
+#if LED_JOURNAL_ENABLE
+    stats->journal_digest = lite_led_journal_digest();
+#endif
+#if LED_THERMAL_ENABLE
+    stats->temp_dc = (int16_t)(g_led_thermal_temp_q8 / 256);
+    stats->derate_percent = (uint8_t)((g_led_derate_q8 * LED_MAX_BRIGHTNESS + 128u) >> 8);
+#endif
+
+    return LED_ERROR_NONE;
+}
+
+#if LED_CONTEXT_ENABLE
+/**
+ * @brief Bytes an engine context takes
+ *
+ * @return size_t Size to allocate for lite_led_ctx_init()
+ */
+size_t lite_led_ctx_size(void)
+{
+    return sizeof(struct led_ctx);
+}
+
+/**
+ * @brief Reset an engine context to the power-on state
+ *
+ * The context then has no LEDs initialized. It must not be in use by any
+ * thread while it is reset.
+ *
+ * @param ctx Context of lite_led_ctx_size() bytes
+ * @return int Error code
+ */
+int lite_led_ctx_init(led_ctx_t *ctx)
+{
+    if (ctx == NULL) return LED_ERROR_PARA_INVALID;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->stats.curve_kernel = LED_BREATH_LUT_ENABLE ? LED_KERNEL_LUT : LED_KERNEL_COS;
+#if LED_OUT_LUT_ENABLE
+    ctx->master_q8 = 256;
+    ctx->derate_q8 = 256;
+#endif
+#if LED_THERMAL_ENABLE
+    ctx->thermal_temp_q8 = LED_THERMAL_AMBIENT_DC * 256;
+#endif
+#if LED_SCENE_ENABLE
+    ctx->morph_q8 = 256;
+#endif
+#if LED_SCHED_ENABLE
+    ctx->sched_due_ms = LED_DAY_MS;
+#endif
+#if LED_STRIP_ENABLE && LED_PARALLEL_ENABLE
+    atomic_init(&ctx->palette_dirty, false);
+#endif
+#if LED_PARALLEL_ENABLE
+    atomic_init(&ctx->chunk_next, 0);
+    atomic_init(&ctx->par_updates, 0);
+    atomic_init(&ctx->par_changes, 0);
+#endif
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Select the context the calling thread's API calls work on
+ *
+ * The choice is per thread. Threads start on the built-in context. Parallel
+ * poll workers must select the context being polled before they call
+ * lite_led_poll_work().
+ *
+ * @param ctx Context set up by lite_led_ctx_init(), NULL = built-in context
+ * @return int Error code
+ */
+int lite_led_ctx_select(led_ctx_t *ctx)
+{
+    g_led_ctx = (ctx != NULL) ? ctx : &g_led_ctx_main;
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Context the calling thread works on
+ *
+ * @return led_ctx_t* Selected context (the built-in one unless changed)
+ */
+led_ctx_t *lite_led_ctx_current(void)
+{
+    return g_led_ctx;
+}
+#endif
+
+#if LED_SIM_ENABLE
+/**
+ * @brief Headless backend: the brightness goes nowhere
+ *
+ * Output bytes and changes are derived from the engine statistics, so the
+ * backend itself stays free of shared state and safe for parallel polls.
+ */
+static void lite_led_sim_headless_cb(uint8_t percent)
+{
+    (void)percent;
+}
+
+/**
+ * @brief Attach the headless backend to every LED
+ *
+ * @return int Error code
+ */
+int lite_led_sim_init(void)
+{
+    for (uint8_t id = 0; id < LED_NUM; id++) {
+        lite_led_init(id, lite_led_sim_headless_cb);
+    }
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Run the engine on a virtual clock
+ *
+ * Polls back to back without waiting for LED_POLL_PERIOD_MS, then reports
+ * simulated time against host time spent.
+ *
+ * @param ticks Number of polls to simulate
+ * @param report Output report (may be NULL)
+ * @return int Error code
+ */
+int lite_led_sim_run(uint32_t ticks, led_sim_report_t *report)
+{
+    led_stats_t before = g_led_stats;
+    clock_t start = clock();
+    uint64_t wall_us;
+
+    for (uint32_t i = 0; i < ticks; i++) {
+        lite_led_poll_handle();
+    }
+
+    if (report == NULL) return LED_ERROR_NONE;
+
+    wall_us = (uint64_t)(clock() - start) * 1000000u / CLOCKS_PER_SEC;
+    if (wall_us == 0) wall_us = 1;
+
+    memset(report, 0, sizeof(*report));
+    report->ticks = ticks;
+    report->sim_ms = (uint64_t)ticks * LED_POLL_PERIOD_MS;
+    report->wall_us = wall_us;
+    report->updates = g_led_stats.update_count - before.update_count;
+    report->changes = g_led_stats.change_count - before.change_count;
+    report->bytes = report->updates * LED_SIM_BYTES_PER_UPDATE + (g_led_stats.strip_bytes - before.strip_bytes);
+    report->updates_per_sec = report->updates * 1000000u / wall_us;
+    report->speedup_x100 = (uint32_t)(report->sim_ms * 100000u / wall_us);
+
+    return LED_ERROR_NONE;
+}
+
+#if LED_CONTEXT_ENABLE
+// Site: many contexts polled in lockstep on one virtual clock
+static led_ctx_t *const *g_led_site;
+static size_t g_led_site_num;
+static uint32_t g_led_site_tick;                // Site polls completed
+static atomic_size_t g_led_site_next;           // Next context to claim in this poll
+static atomic_uint_least64_t g_led_site_updates;
+static atomic_uint_least64_t g_led_site_changes;
+static atomic_uint_least64_t g_led_site_bytes;
+
+/**
+ * @brief Set up a site of engine contexts and clear its totals
+ *
+ * Every context must have been set up by lite_led_ctx_init() and stay
+ * valid while the site runs. A site poll advances all of them by one
+ * LED_POLL_PERIOD_MS, so they share one virtual clock.
+ *
+ * @param ctx Contexts of the site
+ * @param count Number of contexts
+ * @return int Error code
+ */
+int lite_led_site_start(led_ctx_t *const *ctx, size_t count)
+{
+    if (ctx == NULL || count == 0) return LED_ERROR_PARA_INVALID;
+    for (size_t i = 0; i < count; i++) {
+        if (ctx[i] == NULL) return LED_ERROR_PARA_INVALID;
+    }
+
+    g_led_site = ctx;
+    g_led_site_num = count;
+    g_led_site_tick = 0;
+    atomic_store(&g_led_site_next, count);
+    atomic_store(&g_led_site_updates, 0);
+    atomic_store(&g_led_site_changes, 0);
+    atomic_store(&g_led_site_bytes, 0);
+
+    return LED_ERROR_NONE;
+}
+
+/**
+ * @brief Start a site poll
+ *
+ * Must be called by one thread before any worker calls lite_led_site_work().
+ */
+void lite_led_site_begin(void)
+{
+    atomic_store(&g_led_site_next, 0);
+}
+
+/**
+ * @brief Claim the next context of the site poll and poll it once
+ *
+ * Workers keep calling this until it returns false, like
+ * lite_led_poll_work() on the LEDs of one engine. The calling thread's
+ * selected context is restored afterwards.
+ *
+ * @return true if a context was polled, false if none are left
+ */
+bool lite_led_site_work(void)
+{
+    size_t i = atomic_fetch_add(&g_led_site_next, 1);
+    struct led_ctx *prev = g_led_ctx;
+    led_stats_t before;
+    uint64_t updates;
+
+    if (i >= g_led_site_num) return false;
+
+    g_led_ctx = g_led_site[i];
+    before = g_led_stats;
+    lite_led_poll_handle();
+    updates = g_led_stats.update_count - before.update_count;
+    atomic_fetch_add(&g_led_site_updates, updates);
+    atomic_fetch_add(&g_led_site_changes, g_led_stats.change_count - before.change_count);
+    atomic_fetch_add(&g_led_site_bytes,
+                     updates * LED_SIM_BYTES_PER_UPDATE + (g_led_stats.strip_bytes - before.strip_bytes));
+    g_led_ctx = prev;
+
+    return true;
+}
+
+/**
+ * @brief Finish a site poll
+ *
+ * Must be called by one thread after every worker has returned false from
+ * lite_led_site_work().
+ */
+void lite_led_site_end(void)
+{
+    g_led_site_tick++;
+}
+
+/**
+ * @brief Report what the site polls since lite_led_site_start() did
+ *
+ * @param wall_us Host time the caller measured for those polls (us)
+ * @param report Output report, summed over the contexts
+ * @return int Error code
+ */
+int lite_led_site_report(uint64_t wall_us, led_sim_report_t *report)
+{
+    if (report == NULL) return LED_ERROR_PARA_INVALID;
+    if (wall_us == 0) wall_us = 1;
+
+    memset(report, 0, sizeof(*report));
+    report->ticks = g_led_site_tick;
+    report->sim_ms = (uint64_t)g_led_site_tick * LED_POLL_PERIOD_MS;
+    report->wall_us = wall_us;
+    report->updates = atomic_load(&g_led_site_updates);
+    report->changes = atomic_load(&g_led_site_changes);
+    report->bytes = atomic_load(&g_led_site_bytes);
+    report->updates_per_sec = report->updates * 1000000u / wall_us;
+    report->speedup_x100 = (uint32_t)(report->sim_ms * 100000u / wall_us);
+
+    return LED_ERROR_NONE;
+}
+#endif
+#endif
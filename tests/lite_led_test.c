@@ -0,0 +1,1139 @@
+/**
+ * @file    lite_led_test.c
+ * @brief   Lite LED host tests
+ *
+ * Built by tests/run.sh once per feature variant, against a copy of
+ * lite_led_cfg.h with 16 LEDs and the variant's features switched on.
+ *
+ * Usage:  lite_led_test              Run every check the build supports
+ *         lite_led_test digest       Print digests of a fixed scenario
+ *         lite_led_test feature      Print digests of a scenario using the features built in
+ *         lite_led_test journal f    Record a random journal to file f
+ *
+ * With LED_CONTEXT_ENABLE the digest scenarios run in a context of their
+ * own, so run.sh also checks that a context sends what the built-in
+ * engine sends.
+ *
+ * Checks print a FAIL line per failure and set the exit code. The digest
+ * lines are compared between variants by run.sh: features that are
+ * compiled in but not used must not change what is sent, and a parallel
+ * or timer-scan build must send what the single-threaded build sends.
+ *
+ * @author  HughWu
+ * @date    2025-08-23
+ * @version 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lite_led.h"
+
+#if LED_PARALLEL_ENABLE || LED_CONTEXT_ENABLE
+#include <pthread.h>
+#endif
+
+_Static_assert(LED_NUM >= 16, "lite_led_test needs 16 LEDs, build it through tests/run.sh");
+
+#define TEST_POLLS          (3000)  // Polls of the random scenarios
+#define TEST_HALF           (8)     // Pull mirror: LED i + 8 replays LED i
+#define TEST_CURVE_TOL      (3)     // Largest step between neighbouring breath table entries
+#define TEST_THREADS        (3)     // Poll workers besides the main thread
+#define TEST_CONTEXTS       (5)     // Contexts of the site test
+
+#define TEST_FNV_BASIS      2166136261u
+#define TEST_FNV_PRIME      16777619u
+
+#define TEST_CHECK(cond, ...)                                   \
+    do {                                                        \
+        if (!(cond)) {                                          \
+            printf("FAIL %s:%d: ", __func__, __LINE__);         \
+            printf(__VA_ARGS__);                                \
+            printf("\n");                                       \
+            g_failed++;                                         \
+        }                                                       \
+    } while (0)
+
+static unsigned long g_failed = 0;
+static uint32_t g_seed = 1;
+static uint32_t g_sent[LED_NUM];        // Digest of the levels sent per LED
+static uint8_t g_level[LED_NUM];        // Last level sent per LED
+static uint64_t g_sent_num = 0;
+
+/**
+ * @brief Deterministic random number below n (xorshift32)
+ */
+static uint32_t test_rand(uint32_t n)
+{
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 17;
+    g_seed ^= g_seed << 5;
+
+    return g_seed % n;
+}
+
+/**
+ * @brief Record a level sent to an LED
+ */
+static void test_sent(uint8_t id, uint8_t percent)
+{
+    g_sent[id] = (g_sent[id] ^ percent) * TEST_FNV_PRIME;
+    g_level[id] = percent;
+#if !LED_PARALLEL_ENABLE
+    g_sent_num++;
+#endif
+}
+
+#define TEST_CB(n) static void test_cb_##n(uint8_t percent) { test_sent(n, percent); }
+TEST_CB(0)  TEST_CB(1)  TEST_CB(2)  TEST_CB(3)  TEST_CB(4)  TEST_CB(5)  TEST_CB(6)  TEST_CB(7)
+TEST_CB(8)  TEST_CB(9)  TEST_CB(10) TEST_CB(11) TEST_CB(12) TEST_CB(13) TEST_CB(14) TEST_CB(15)
+
+static const led_set_brt_f g_cb[16] = {
+    test_cb_0,  test_cb_1,  test_cb_2,  test_cb_3,  test_cb_4,  test_cb_5,  test_cb_6,  test_cb_7,
+    test_cb_8,  test_cb_9,  test_cb_10, test_cb_11, test_cb_12, test_cb_13, test_cb_14, test_cb_15,
+};
+
+/**
+ * @brief Initialize the 16 test LEDs and forget what was sent so far
+ */
+static void test_init(void)
+{
+    for (uint8_t id = 0; id < 16; id++) {
+        lite_led_init(id, g_cb[id]);
+    }
+    for (size_t i = 0; i < LED_NUM; i++) {
+        g_sent[i] = TEST_FNV_BASIS;
+    }
+    g_sent_num = 0;
+}
+
+/**
+ * @brief Digest of the levels sent to every LED so far
+ */
+static uint32_t test_sent_digest(void)
+{
+    uint32_t digest = TEST_FNV_BASIS;
+
+    for (size_t i = 0; i < LED_NUM; i++) {
+        digest = (digest ^ g_sent[i]) * TEST_FNV_PRIME;
+    }
+
+    return digest;
+}
+
+#if LED_PARALLEL_ENABLE
+/**
+ * @brief Poll worker: claim chunks of the polled context until none are left
+ */
+static void *test_worker(void *arg)
+{
+#if LED_CONTEXT_ENABLE
+    lite_led_ctx_select((led_ctx_t *)arg);
+#else
+    (void)arg;
+#endif
+    while (lite_led_poll_work()) {}
+
+    return NULL;
+}
+#endif
+
+/**
+ * @brief Run one poll, on several threads in a parallel build
+ */
+static void test_poll(void)
+{
+#if LED_PARALLEL_ENABLE
+    pthread_t th[TEST_THREADS];
+#if LED_CONTEXT_ENABLE
+    void *ctx = lite_led_ctx_current();
+#else
+    void *ctx = NULL;
+#endif
+
+    lite_led_poll_begin();
+    for (int i = 0; i < TEST_THREADS; i++) {
+        pthread_create(&th[i], NULL, test_worker, ctx);
+    }
+    test_worker(ctx);
+    for (int i = 0; i < TEST_THREADS; i++) {
+        pthread_join(th[i], NULL);
+    }
+    lite_led_poll_end();
+#else
+    lite_led_poll_handle();
+#endif
+#if LED_OUTPUT_INTERP_ENABLE
+    for (uint32_t i = 0; i < LED_POLL_PERIOD_MS / LED_OUTPUT_PERIOD_MS; i++) {
+        lite_led_output_poll();
+    }
+#endif
+}
+
+/**
+ * @brief Level of an LED as lite_led_read() reports it
+ */
+static uint8_t test_read(uint8_t id)
+{
+    led_status_t status;
+
+    lite_led_read(id, &status);
+
+    return status.percent;
+}
+
+/**
+ * @brief Random effect of one of the base modes for an LED among n LEDs
+ *
+ * Times are whole polls except fades, which also get odd lengths so that
+ * breath cycles are not a whole number of polls. Fades are at least a
+ * poll long: a shorter one steps more than a cycle per poll.
+ */
+static void test_random_cfg(uint8_t id, uint8_t n, led_cfg_t *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->mode = (led_mode_e)test_rand(LED_MODE_ALTERNATE + 1);
+    cfg->on_ms = test_rand(8) * LED_POLL_PERIOD_MS;
+    cfg->off_ms = test_rand(8) * LED_POLL_PERIOD_MS;
+    cfg->fade_ms = test_rand(4) ? LED_POLL_PERIOD_MS + test_rand(3000) : 0;
+    cfg->alternate_ms = test_rand(8) * LED_POLL_PERIOD_MS;
+    cfg->alter_id = (led_id_e)test_rand(n);
+    if (cfg->alter_id == id) cfg->alter_id = (led_id_e)((id + 1) % n);
+    if (test_rand(3) == 0) cfg->duration_ms = test_rand(6000);
+}
+
+/**
+ * @brief Make the features that are compiled in but unused neutral
+ */
+static void test_neutral(void)
+{
+#if LED_THERMAL_ENABLE
+    // The power estimate would derate a busy scenario
+    lite_led_thermal_set_temp(LED_THERMAL_AMBIENT_DC);
+#endif
+}
+
+#if LED_THERMAL_ENABLE
+/**
+ * @brief The power estimate averages over the initialized LEDs only
+ *
+ * Two LEDs on at full level heat up as much as all of them would; the
+ * slots that were never set up must not dilute the estimate. Needs the
+ * sensor never fed, so it runs before test_neutral().
+ */
+static void test_thermal(void)
+{
+    led_cfg_t on = { .mode = LED_MODE_ON };
+    led_stats_t stats;
+
+    lite_led_init(0, g_cb[0]);
+    lite_led_init(1, g_cb[1]);
+    lite_led_write(0, &on);
+    lite_led_write(1, &on);
+    for (uint32_t ms = 0; ms < 5 * LED_THERMAL_TAU_MS; ms += LED_POLL_PERIOD_MS) {
+        test_poll();
+    }
+    lite_led_get_stats(&stats);
+    TEST_CHECK(stats.temp_dc > LED_THERMAL_START_DC, "%d dC with 2 LEDs on, derating starts at %d",
+               (int)stats.temp_dc, LED_THERMAL_START_DC);
+    TEST_CHECK(g_level[0] < LED_MAX_BRIGHTNESS, "LED 0 not derated: %u", (unsigned)g_level[0]);
+}
+#endif
+
+/**
+ * @brief Print digests of a random scenario that only uses lite_led_write()
+ *
+ * "sent" covers the levels handed to the callbacks, "state" the levels
+ * lite_led_read() reports after each poll.
+ */
+static void test_digest(void)
+{
+    uint32_t state = TEST_FNV_BASIS;
+    led_cfg_t cfg;
+    uint8_t id;
+
+    g_seed = 12345;
+    test_neutral();
+    test_init();
+    for (uint32_t tick = 0; tick < TEST_POLLS; tick++) {
+        while (test_rand(4) == 0) {
+            id = (uint8_t)test_rand(16);
+            test_random_cfg(id, 16, &cfg);
+            lite_led_write(id, &cfg);
+        }
+        test_poll();
+        for (id = 0; id < 16; id++) {
+            state = (state ^ test_read(id)) * TEST_FNV_PRIME;
+        }
+    }
+
+    printf("sent %08x\n", (unsigned)test_sent_digest());
+    printf("state %08x\n", (unsigned)state);
+}
+
+#if LED_SCENE_ENABLE
+/**
+ * @brief Recall a random scene that covers some of the LEDs
+ *
+ * Two scenes take turns, so the one filled is never the live one.
+ */
+static void test_random_scene(void)
+{
+    static led_scene_t scene[2];
+    static uint8_t next = 0;
+    led_scene_t *s = &scene[next];
+    led_cfg_t cfg;
+
+    memset(s, 0, sizeof(*s));
+    for (uint8_t id = 0; id < 16; id++) {
+        if (test_rand(2) != 0) continue;
+        test_random_cfg(id, 16, &cfg);
+        // Scenes that turn LEDs into followers of LEDs they leave alone
+        if (test_rand(2) == 0) cfg.mode = LED_MODE_ALTERNATE;
+        lite_led_scene_set(s, id, &cfg);
+    }
+    lite_led_scene_recall(s, test_rand(2) ? test_rand(2000) : 0);
+    next ^= 1;
+}
+#endif
+
+/**
+ * @brief Print digests of a random scenario that uses the features built in
+ *
+ * run.sh compares it between a build and the same build with
+ * LED_PARALLEL_ENABLE or LED_TIMER_SCAN_ENABLE added.
+ */
+static void test_feature(void)
+{
+    uint32_t state = TEST_FNV_BASIS;
+    led_cfg_t cfg;
+    uint8_t id;
+
+    g_seed = 999;
+    test_neutral();
+    test_init();
+#if LED_CCT_ENABLE
+    lite_led_cct_init(0, 14, 15);
+#endif
+    for (uint32_t tick = 0; tick < TEST_POLLS; tick++) {
+        while (test_rand(4) == 0) {
+            id = (uint8_t)test_rand(16);
+            test_random_cfg(id, 16, &cfg);
+            lite_led_write(id, &cfg);
+        }
+#if LED_SCENE_ENABLE
+        if (test_rand(40) == 0) test_random_scene();
+#endif
+#if LED_CLOCK_ENABLE
+        if (test_rand(100) == 0) lite_led_clock_set_speed(LED_CLOCK_MUSIC, 250 + test_rand(2000));
+        if (test_rand(50) == 0) lite_led_clock_attach((uint8_t)test_rand(16), (led_clock_e)test_rand(LED_CLOCK_MAX));
+#endif
+#if LED_PULL_ENABLE
+        if (test_rand(100) == 0) lite_led_set_pull((uint8_t)test_rand(16), test_rand(2) != 0);
+#endif
+#if LED_CCT_ENABLE
+        if (test_rand(50) == 0) {
+            lite_led_cct_write(0, (uint16_t)(LED_CCT_MIN_K + test_rand(LED_CCT_MAX_K - LED_CCT_MIN_K + 1)),
+                               test_rand(2) ? test_rand(3000) : 0);
+        }
+#endif
+        test_poll();
+        for (id = 0; id < 16; id++) {
+            state = (state ^ test_read(id)) * TEST_FNV_PRIME;
+        }
+    }
+
+    printf("sent %08x\n", (unsigned)test_sent_digest());
+    printf("state %08x\n", (unsigned)state);
+}
+
+#if LED_PULL_ENABLE
+/**
+ * @brief Check a level read from a pulled LED against its pushed twin
+ */
+static void test_pull_compare(uint32_t tick, uint8_t id, led_mode_e mode)
+{
+    uint8_t push = test_read(id);
+    uint8_t pull = test_read((uint8_t)(id + TEST_HALF));
+    int diff = (int)pull - (int)push;
+    // Breath and fades accumulate the phase when pushed and multiply it out
+    // when pulled: the float rounding may move them to a neighbouring entry
+    int tol = (mode == LED_MODE_BREATH || mode == LED_MODE_FADE_IN || mode == LED_MODE_FADE_OUT) ?
+              TEST_CURVE_TOL : 0;
+
+    TEST_CHECK(diff >= -tol && diff <= tol, "tick %u LED %u mode %d: push %u pull %u",
+               (unsigned)tick, (unsigned)id, (int)mode, (unsigned)push, (unsigned)pull);
+}
+
+/**
+ * @brief A follower copies its pulled leader's state at its own edges
+ *
+ * Leader 0 blinks 300/300 ms, follower 1 alternates every 500 ms; LEDs 8
+ * and 9 run the same pair pulled.
+ */
+static void test_pull_follower(void)
+{
+    static const uint8_t expect[] = {
+        0, 0, 0, 0, 0, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 0,
+    };
+    led_cfg_t blink = { .mode = LED_MODE_BLINK, .on_ms = 300, .off_ms = 300 };
+    led_cfg_t alt = { .mode = LED_MODE_ALTERNATE, .alternate_ms = 500 };
+
+    test_init();
+    lite_led_set_pull(8, true);
+    lite_led_set_pull(9, true);
+    lite_led_write(0, &blink);
+    lite_led_write(8, &blink);
+    alt.alter_id = (led_id_e)0;
+    lite_led_write(1, &alt);
+    alt.alter_id = (led_id_e)8;
+    lite_led_write(9, &alt);
+
+    for (size_t i = 0; i < sizeof(expect); i++) {
+        test_poll();
+        TEST_CHECK(test_read(1) == expect[i], "poll %u: push %u, expected %u",
+                   (unsigned)i, (unsigned)test_read(1), (unsigned)expect[i]);
+        TEST_CHECK(test_read(9) == expect[i], "poll %u: pull %u, expected %u",
+                   (unsigned)i, (unsigned)test_read(9), (unsigned)expect[i]);
+    }
+    lite_led_set_pull(8, false);
+    lite_led_set_pull(9, false);
+}
+
+/**
+ * @brief Pulled LEDs show what pushed LEDs with the same effects show
+ *
+ * LEDs 0-7 run random effects pushed, LEDs 8-15 the same effects pulled,
+ * written on the same polls; ALTERNATE pairs stay within each half.
+ */
+static void test_pull_mirror(void)
+{
+    led_mode_e mode[TEST_HALF];
+    led_cfg_t cfg;
+    uint8_t id;
+
+    g_seed = 777;
+    test_init();
+    for (id = 0; id < TEST_HALF; id++) {
+        lite_led_set_pull((uint8_t)(id + TEST_HALF), true);
+        mode[id] = LED_MODE_OFF;
+    }
+
+    for (uint32_t tick = 0; tick < TEST_POLLS; tick++) {
+        while (test_rand(3) == 0) {
+            id = (uint8_t)test_rand(TEST_HALF);
+            test_random_cfg(id, TEST_HALF, &cfg);
+            // Followers are the interesting case
+            if (test_rand(2) == 0) cfg.mode = LED_MODE_ALTERNATE;
+            mode[id] = cfg.mode;
+            lite_led_write(id, &cfg);
+            cfg.alter_id = (led_id_e)(cfg.alter_id + TEST_HALF);
+            lite_led_write((uint8_t)(id + TEST_HALF), &cfg);
+        }
+#if LED_CLOCK_ENABLE
+        if (test_rand(200) == 0) lite_led_clock_set_speed(LED_CLOCK_SYSTEM, 250 + test_rand(2000));
+#endif
+        test_poll();
+        for (id = 0; id < TEST_HALF; id++) {
+            test_pull_compare(tick, id, mode[id]);
+        }
+    }
+
+#if LED_CLOCK_ENABLE
+    lite_led_clock_set_speed(LED_CLOCK_SYSTEM, 1000);
+#endif
+    for (id = 0; id < TEST_HALF; id++) {
+        lite_led_set_pull((uint8_t)(id + TEST_HALF), false);
+    }
+}
+#endif
+
+#if LED_GOV_ENABLE
+static uint32_t g_now_us = 0;
+static uint32_t g_poll_cost_us = 0;     // Cost the governor measures for every poll
+
+/**
+ * @brief Governor time source: every poll costs g_poll_cost_us
+ */
+static uint32_t test_now_us(void)
+{
+    g_now_us += g_poll_cost_us;
+
+    return g_now_us;
+}
+
+/**
+ * @brief Low-priority LEDs catch up by the clock time that really passed
+ *
+ * Under overload they run every fourth poll; an ON effect must still end
+ * on time, also on a 1.5x clock that steps 1, 2, 1, 2... ticks per poll.
+ * Without a timer the governor does not run at all.
+ */
+static void test_gov(void)
+{
+    led_cfg_t on = { .mode = LED_MODE_ON, .duration_ms = 30000 };
+    led_stats_t stats;
+    uint32_t off[3] = { 0 };
+    bool lit[3] = { false };
+    uint32_t ticks = on.duration_ms / LED_POLL_PERIOD_MS;
+    uint32_t polls;
+    uint32_t n;
+
+    test_init();
+    for (n = 0; n < 100; n++) {
+        test_poll();
+    }
+    lite_led_get_stats(&stats);
+    TEST_CHECK(stats.gov_level == LED_GOV_FULL && stats.poll_us == 0,
+               "governor ran without a timer: level %d, %u us", (int)stats.gov_level, (unsigned)stats.poll_us);
+
+    lite_led_gov_set_timer(test_now_us);
+    g_poll_cost_us = LED_POLL_PERIOD_MS * 1000u;
+    for (n = 0; n < 1000; n++) {
+        lite_led_get_stats(&stats);
+        if (stats.gov_level == LED_GOV_DEFER_LOW) break;
+        test_poll();
+    }
+    TEST_CHECK(stats.gov_level == LED_GOV_DEFER_LOW, "governor at level %d", (int)stats.gov_level);
+
+#if LED_CLOCK_ENABLE
+    lite_led_clock_set_speed(LED_CLOCK_SYSTEM, 1500);
+    // The tick after the duration turns the LED off
+    polls = ((ticks + 1) * 2 + 2) / 3;
+#else
+    polls = ticks + 1;
+#endif
+    for (uint8_t id = 0; id < 3; id++) {
+        lite_led_set_priority(id, true);
+        lite_led_write(id, &on);
+    }
+    for (n = 1; n <= polls + 8; n++) {
+        test_poll();
+        for (uint8_t id = 0; id < 3; id++) {
+            if (off[id] == 0 && lit[id] && test_read(id) == LED_MIN_BRIGHTNESS) off[id] = n;
+            lit[id] = (test_read(id) == LED_MAX_BRIGHTNESS);
+        }
+    }
+    // A deferred LED notices at its next turn, at most three polls late
+    for (uint8_t id = 0; id < 3; id++) {
+        TEST_CHECK(off[id] >= polls && off[id] < polls + 4, "LED %u off after %u polls, expected %u",
+                   (unsigned)id, (unsigned)off[id], (unsigned)polls);
+        lite_led_set_priority(id, false);
+    }
+
+    g_poll_cost_us = 0;
+    for (n = 0; n < 1000; n++) {
+        lite_led_get_stats(&stats);
+        if (stats.gov_level == LED_GOV_FULL) break;
+        test_poll();
+    }
+    TEST_CHECK(stats.gov_level == LED_GOV_FULL, "governor stuck at level %d", (int)stats.gov_level);
+
+    // Clearing the timer restores full quality at once
+    g_poll_cost_us = LED_POLL_PERIOD_MS * 1000u;
+    for (n = 0; n < 100; n++) {
+        test_poll();
+    }
+    lite_led_gov_set_timer(NULL);
+    lite_led_get_stats(&stats);
+    TEST_CHECK(stats.gov_level == LED_GOV_FULL, "level %d after the timer was cleared", (int)stats.gov_level);
+    for (n = 0; n < 100; n++) {
+        test_poll();
+    }
+    lite_led_get_stats(&stats);
+    TEST_CHECK(stats.gov_level == LED_GOV_FULL && stats.poll_us == 0,
+               "governor ran after the timer was cleared: level %d, %u us",
+               (int)stats.gov_level, (unsigned)stats.poll_us);
+#if LED_CLOCK_ENABLE
+    lite_led_clock_set_speed(LED_CLOCK_SYSTEM, 1000);
+#endif
+}
+#endif
+
+#if LED_AUTOTUNE_ENABLE
+#if LED_JOURNAL_ENABLE
+#define TEST_KERNEL_POLLS   (200)
+
+/**
+ * @brief Levels of a set of breathing LEDs, poll by poll
+ */
+static void test_kernel_run(uint8_t levels[TEST_KERNEL_POLLS][16])
+{
+    led_cfg_t cfg = { .mode = LED_MODE_BREATH };
+
+    test_init();
+    for (uint8_t id = 0; id < 16; id++) {
+        cfg.fade_ms = 100u + 250u * id;
+        lite_led_write(id, &cfg);
+    }
+    for (uint32_t n = 0; n < TEST_KERNEL_POLLS; n++) {
+        test_poll();
+        for (uint8_t id = 0; id < 16; id++) {
+            levels[n][id] = test_read(id);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief The autotuner only picks kernels that draw the configured curve
+ *
+ * With the journal, every kernel is forced through a KERNEL record: the
+ * ones that draw another curve are refused, the others must stay within
+ * one percent of the reference kernel on breathing LEDs.
+ */
+static void test_autotune(void)
+{
+#if LED_BREATH_LUT_ENABLE
+    const bool match[LED_KERNEL_MAX] = {
+        [LED_KERNEL_LUT] = true, [LED_KERNEL_LUT_HALF] = true, [LED_KERNEL_POLY] = true,
+    };
+#else
+    const bool match[LED_KERNEL_MAX] = {
+        [LED_KERNEL_COSF] = true, [LED_KERNEL_COS] = true, [LED_KERNEL_POLY] = true,
+    };
+#endif
+    led_stats_t stats;
+    int err;
+
+    err = lite_led_autotune(LED_KERNEL_MAX * 2);
+    TEST_CHECK(err == LED_ERROR_NONE, "autotune returned %d", err);
+    lite_led_get_stats(&stats);
+    TEST_CHECK(match[stats.curve_kernel], "autotune picked kernel %d", (int)stats.curve_kernel);
+
+#if LED_JOURNAL_ENABLE
+    const led_kernel_e ref = LED_BREATH_LUT_ENABLE ? LED_KERNEL_LUT : LED_KERNEL_COS;
+    static uint8_t expect[TEST_KERNEL_POLLS][16];
+    static uint8_t levels[TEST_KERNEL_POLLS][16];
+    led_journal_rec_t rec;
+    int diff, worst;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.op = LED_JOURNAL_KERNEL;
+    rec.arg[0] = ref;
+    lite_led_journal_apply(&rec, NULL);
+    test_kernel_run(expect);
+    for (int k = 0; k < LED_KERNEL_MAX; k++) {
+        rec.arg[0] = (uint32_t)k;
+        err = lite_led_journal_apply(&rec, NULL);
+        TEST_CHECK((err == LED_ERROR_NONE) == match[k], "kernel %d applied with %d", k, err);
+        if (err != LED_ERROR_NONE) continue;
+
+        test_kernel_run(levels);
+        worst = 0;
+        for (uint32_t n = 0; n < TEST_KERNEL_POLLS; n++) {
+            for (uint8_t id = 0; id < 16; id++) {
+                diff = abs((int)levels[n][id] - (int)expect[n][id]);
+                if (diff > worst) worst = diff;
+            }
+        }
+        TEST_CHECK(worst <= 1, "kernel %d is %d%% off the reference", k, worst);
+    }
+    rec.arg[0] = ref;
+    lite_led_journal_apply(&rec, NULL);
+#endif
+}
+#endif
+
+#if LED_CONTEXT_ENABLE
+/**
+ * @brief Random writes and polls on the selected context
+ *
+ * @return Digest of the levels sent
+ */
+static uint32_t test_context_run(void)
+{
+    led_cfg_t cfg;
+    uint8_t id;
+
+    g_seed = 4242;
+    test_neutral();
+    test_init();
+    for (uint32_t tick = 0; tick < TEST_POLLS / 10; tick++) {
+        while (test_rand(4) == 0) {
+            id = (uint8_t)test_rand(16);
+            test_random_cfg(id, 16, &cfg);
+            lite_led_write(id, &cfg);
+        }
+        test_poll();
+    }
+
+    return test_sent_digest();
+}
+
+#if LED_SIM_ENABLE
+/**
+ * @brief Site worker thread: claim contexts until none are left
+ */
+static void *test_site_worker(void *arg)
+{
+    (void)arg;
+    while (lite_led_site_work()) {}
+
+    return NULL;
+}
+#endif
+
+/**
+ * @brief Contexts are engines of their own
+ *
+ * A scenario run in a fresh context sends what it sends in the built-in
+ * one, without moving the built-in one or another context. With the
+ * simulator, a site of identical contexts polled by several threads
+ * counts each context's updates once.
+ */
+static void test_context(void)
+{
+    led_ctx_t *main_ctx = lite_led_ctx_current();
+    led_ctx_t *ctx[TEST_CONTEXTS];
+    led_stats_t stats, before;
+    uint32_t expect, digest;
+
+    for (int i = 0; i < TEST_CONTEXTS; i++) {
+        ctx[i] = malloc(lite_led_ctx_size());
+        TEST_CHECK(ctx[i] != NULL && lite_led_ctx_init(ctx[i]) == LED_ERROR_NONE, "context %d not set up", i);
+        if (ctx[i] == NULL) return;
+    }
+    TEST_CHECK(lite_led_ctx_init(NULL) == LED_ERROR_PARA_INVALID, "NULL context accepted");
+
+    expect = test_context_run();
+    lite_led_get_stats(&before);
+
+    lite_led_ctx_select(ctx[0]);
+    TEST_CHECK(lite_led_ctx_current() == ctx[0], "context not selected");
+    digest = test_context_run();
+    TEST_CHECK(digest == expect, "context sent %08x, built-in %08x", (unsigned)digest, (unsigned)expect);
+    lite_led_get_stats(&stats);
+    TEST_CHECK(stats.tick == TEST_POLLS / 10, "context at tick %u", (unsigned)stats.tick);
+
+    lite_led_ctx_select(ctx[1]);
+    lite_led_get_stats(&stats);
+    TEST_CHECK(stats.tick == 0 && stats.update_count == 0, "untouched context at tick %u, %u updates",
+               (unsigned)stats.tick, (unsigned)stats.update_count);
+
+    lite_led_ctx_select(NULL);
+    TEST_CHECK(lite_led_ctx_current() == main_ctx, "NULL did not select the built-in context");
+    lite_led_get_stats(&stats);
+    TEST_CHECK(stats.tick == before.tick && stats.update_count == before.update_count,
+               "built-in context moved: tick %u -> %u", (unsigned)before.tick, (unsigned)stats.tick);
+
+#if LED_SIM_ENABLE
+    led_cfg_t cfg = { .mode = LED_MODE_BREATH };
+    led_sim_report_t report;
+    pthread_t th[TEST_THREADS];
+    uint64_t updates = 0;
+
+    for (int i = 0; i < TEST_CONTEXTS; i++) {
+        lite_led_ctx_init(ctx[i]);
+        lite_led_ctx_select(ctx[i]);
+        lite_led_sim_init();
+        for (uint8_t id = 0; id < LED_NUM; id++) {
+            cfg.fade_ms = 300u + 70u * id;
+            lite_led_write(id, &cfg);
+        }
+    }
+    lite_led_ctx_select(NULL);
+
+    TEST_CHECK(lite_led_site_start(ctx, 0) == LED_ERROR_PARA_INVALID, "empty site accepted");
+    lite_led_site_start(ctx, TEST_CONTEXTS);
+    for (uint32_t tick = 0; tick < TEST_POLLS / 10; tick++) {
+        lite_led_site_begin();
+        for (int i = 0; i < TEST_THREADS; i++) {
+            pthread_create(&th[i], NULL, test_site_worker, NULL);
+        }
+        test_site_worker(NULL);
+        for (int i = 0; i < TEST_THREADS; i++) {
+            pthread_join(th[i], NULL);
+        }
+        lite_led_site_end();
+    }
+    TEST_CHECK(lite_led_ctx_current() == main_ctx, "site worker left another context selected");
+    lite_led_site_report(1000, &report);
+
+    for (int i = 0; i < TEST_CONTEXTS; i++) {
+        lite_led_ctx_select(ctx[i]);
+        lite_led_get_stats(&stats);
+        TEST_CHECK(stats.tick == TEST_POLLS / 10, "context %d at tick %u", i, (unsigned)stats.tick);
+        if (i > 0) {
+            TEST_CHECK(stats.update_count == before.update_count, "context %d: %u updates, context 0 %u", i,
+                       (unsigned)stats.update_count, (unsigned)before.update_count);
+        }
+        before = stats;
+        updates += stats.update_count;
+    }
+    lite_led_ctx_select(NULL);
+    TEST_CHECK(report.ticks == TEST_POLLS / 10 && report.sim_ms == (uint64_t)report.ticks * LED_POLL_PERIOD_MS,
+               "site report: %u ticks", (unsigned)report.ticks);
+    TEST_CHECK(updates != 0 && report.updates == updates, "site report: %u updates, contexts %u",
+               (unsigned)report.updates, (unsigned)updates);
+#endif
+
+    for (int i = 0; i < TEST_CONTEXTS; i++) {
+        free(ctx[i]);
+    }
+}
+
+/**
+ * @brief Select a fresh context for a digest scenario
+ */
+static void test_context_fresh(void)
+{
+    static led_ctx_t *ctx = NULL;
+
+    if (ctx == NULL) ctx = malloc(lite_led_ctx_size());
+    if (ctx == NULL) return;
+    lite_led_ctx_init(ctx);
+    lite_led_ctx_select(ctx);
+}
+#endif
+
+#if LED_CCT_ENABLE
+/**
+ * @brief Initializing an entity again releases its old channels only
+ */
+static void test_cct(void)
+{
+    led_cfg_t on = { .mode = LED_MODE_ON };
+    led_cfg_t off = { .mode = LED_MODE_OFF };
+    int err;
+
+    test_init();
+    err = lite_led_cct_init(0, 0, 1);
+    TEST_CHECK(err == LED_ERROR_NONE, "cct_init returned %d", err);
+    lite_led_write(0, &on);
+    lite_led_write(2, &off);
+    lite_led_write(3, &off);
+    lite_led_cct_write(0, LED_CCT_MAX_K, 0);
+    test_poll();
+    test_poll();
+    TEST_CHECK(g_level[0] == 0 && g_level[1] == 100, "cold white sent %u/%u", g_level[0], g_level[1]);
+
+    // LED 1 is the cold channel: its own effect waits for the release
+    lite_led_write(1, &off);
+    err = lite_led_cct_init(0, 2, 3);
+    TEST_CHECK(err == LED_ERROR_NONE, "cct_init returned %d", err);
+    TEST_CHECK(g_level[0] == 100 && g_level[1] == 0, "released channels show %u/%u", g_level[0], g_level[1]);
+    for (int i = 0; i < 4; i++) {
+        test_poll();
+    }
+    TEST_CHECK(g_level[0] == 100 && g_level[1] == 0, "released channels show %u/%u", g_level[0], g_level[1]);
+    TEST_CHECK(g_level[2] == 0 && g_level[3] == 0, "new channels show %u/%u", g_level[2], g_level[3]);
+
+#if LED_CCT_NUM > 1
+    err = lite_led_cct_init(1, 3, 4);
+    TEST_CHECK(err == LED_ERROR_PARA_INVALID, "cct_init took a channel of another entity: %d", err);
+    err = lite_led_cct_init(1, 4, 5);
+    TEST_CHECK(err == LED_ERROR_NONE, "cct_init returned %d", err);
+#endif
+}
+#endif
+
+#if LED_STRIP_ENABLE
+#define TEST_STRIP_PIXELS   (4)
+#define TEST_STRIP_BYTES    (TEST_STRIP_PIXELS * 3)
+#define TEST_PORT_SIZE      (TEST_STRIP_BYTES * LED_STRIP_PORT_WIDTH)
+
+static size_t g_port_len = 0;
+
+static void test_strip_write(const uint8_t *data, size_t len)
+{
+    (void)data;
+    (void)len;
+}
+
+static void test_port_write(const uint8_t *data, size_t len)
+{
+    (void)data;
+    g_port_len = len;
+}
+
+/**
+ * @brief Port stream encoding and port buffer size checks
+ */
+static void test_strip(void)
+{
+    static uint8_t frame[LED_STRIP_PORT_WIDTH][TEST_STRIP_BYTES];
+    static uint8_t out[1 + TEST_PORT_SIZE];
+    static uint8_t port[TEST_PORT_SIZE];
+    static uint8_t pixels[LED_STRIP_NUM][TEST_STRIP_PIXELS + 1];
+    static uint8_t frames[LED_STRIP_NUM][TEST_STRIP_BYTES + 3];
+    const uint8_t *src[LED_STRIP_PORT_WIDTH];
+    size_t lens[LED_STRIP_PORT_WIDTH];
+    size_t len;
+    int err;
+
+    g_seed = 31;
+    for (size_t s = 0; s < LED_STRIP_PORT_WIDTH; s++) {
+        for (size_t k = 0; k < TEST_STRIP_BYTES; k++) {
+            frame[s][k] = (uint8_t)test_rand(256);
+        }
+        src[s] = frame[s];
+        lens[s] = TEST_STRIP_BYTES;
+    }
+    // Port words at an odd address: the encoder must not assume alignment
+    len = lite_led_strip_encode(src, lens, LED_STRIP_PORT_WIDTH, TEST_STRIP_BYTES, &out[1]);
+    TEST_CHECK(len == TEST_PORT_SIZE, "encoded %u bytes", (unsigned)len);
+    for (size_t k = 0; k < TEST_STRIP_BYTES; k++) {
+        for (int b = 0; b < 8; b++) {
+            uint32_t word = 0;
+            uint32_t expect = 0;
+#if LED_STRIP_PORT_WIDTH == 8
+            word = out[1 + k * 8 + b];
+#else
+            uint16_t w16;
+
+            memcpy(&w16, &out[1 + (k * 8 + b) * 2], sizeof(w16));
+            word = w16;
+#endif
+            for (size_t s = 0; s < LED_STRIP_PORT_WIDTH; s++) {
+                expect |= (uint32_t)((frame[s][k] >> (7 - b)) & 1u) << s;
+            }
+            TEST_CHECK(word == expect, "byte %u bit %d: word %x, expected %x",
+                       (unsigned)k, b, (unsigned)word, (unsigned)expect);
+        }
+    }
+
+    // The port buffer must hold the stream of the longest strip
+    err = lite_led_strip_init(0, pixels[0], frames[0], TEST_STRIP_PIXELS, test_strip_write);
+    TEST_CHECK(err == LED_ERROR_NONE, "strip_init returned %d", err);
+    err = lite_led_strip_port_init(port, TEST_PORT_SIZE - 1, test_port_write);
+    TEST_CHECK(err == LED_ERROR_PARA_INVALID, "port_init took a short buffer: %d", err);
+    err = lite_led_strip_port_init(port, TEST_PORT_SIZE, test_port_write);
+    TEST_CHECK(err == LED_ERROR_NONE, "port_init returned %d", err);
+#if LED_STRIP_NUM > 1
+    err = lite_led_strip_init(1, pixels[1], frames[1], TEST_STRIP_PIXELS + 1, test_strip_write);
+    TEST_CHECK(err == LED_ERROR_PARA_INVALID, "strip_init outgrew the port buffer: %d", err);
+#endif
+    test_poll();
+    TEST_CHECK(g_port_len == TEST_PORT_SIZE, "port sent %u bytes", (unsigned)g_port_len);
+    lite_led_strip_port_init(NULL, 0, NULL);
+}
+
+#if LED_MASTER_ENABLE
+/**
+ * @brief A palette entry bound to a parked LED is scaled by what the LED shows
+ *
+ * The master level makes the level sent differ from the effect's own.
+ */
+static void test_palette(void)
+{
+    static uint8_t pixels[TEST_STRIP_PIXELS];
+    static uint8_t frame[TEST_STRIP_BYTES];
+    static const uint8_t index[TEST_STRIP_PIXELS] = { 1, 1, 1, 1 };
+    led_cfg_t on = { .mode = LED_MODE_ON };
+    led_rgb_t white = { 200, 200, 200 };
+
+    test_init();
+    lite_led_set_master(50);
+    lite_led_write(5, &on);
+    test_poll();
+    lite_led_strip_init(0, pixels, frame, TEST_STRIP_PIXELS, test_strip_write);
+    lite_led_strip_set(0, 0, index, TEST_STRIP_PIXELS);
+    lite_led_palette_set(1, white);
+    lite_led_palette_bind(1, 5);
+    test_poll();
+    test_poll();
+    TEST_CHECK(g_level[5] < LED_MAX_BRIGHTNESS, "master not applied: %u", g_level[5]);
+    TEST_CHECK(frame[0] == (white.r * g_level[5] + 50) / 100, "pixel %u for LED level %u", frame[0], g_level[5]);
+
+    lite_led_palette_bind(1, LED_INVALID);
+    lite_led_set_master(LED_MAX_BRIGHTNESS);
+}
+#endif
+#endif
+
+#if LED_JOURNAL_ENABLE
+static FILE *g_journal_file = NULL;
+
+/**
+ * @brief Journal flush callback: append the records to the file
+ */
+static void test_journal_flush(const led_journal_rec_t *recs, size_t count)
+{
+    fwrite(recs, sizeof(*recs), count, g_journal_file);
+}
+
+/**
+ * @brief Record a random journal of base-mode writes for lite_led_replay
+ *
+ * @return int 0 on success
+ */
+static int test_journal(const char *path)
+{
+    static led_journal_rec_t buf[256];
+    led_cfg_t cfg;
+    uint8_t id;
+    int err;
+
+    g_journal_file = fopen(path, "wb");
+    if (g_journal_file == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    g_seed = 4242;
+    test_neutral();
+    test_init();
+    lite_led_journal_start(buf, sizeof(buf) / sizeof(buf[0]), test_journal_flush);
+    for (uint32_t tick = 0; tick < TEST_POLLS; tick++) {
+        while (test_rand(3) == 0) {
+            id = (uint8_t)test_rand(16);
+            test_random_cfg(id, 16, &cfg);
+            if (test_rand(2) == 0) cfg.mode = LED_MODE_ALTERNATE;
+            lite_led_write(id, &cfg);
+        }
+        test_poll();
+    }
+    err = lite_led_journal_stop(NULL);
+    fclose(g_journal_file);
+    TEST_CHECK(err == LED_ERROR_NONE, "journal_stop returned %d", err);
+
+    return g_failed != 0;
+}
+
+/**
+ * @brief Check which calls the journal logs
+ *
+ * Rejected writes leave no record, whatever their mode. Schedule calls
+ * are logged for reference and the entries that run as the calls they make.
+ */
+static void test_journal_calls(void)
+{
+    static led_journal_rec_t buf[64];
+    const led_mode_e modes[] = { LED_MODE_SCRIPT, LED_MODE_TRACK, LED_MODE_ALTERNATE };
+    led_cfg_t cfg;
+    size_t count, inits = 0;
+    int err;
+#if LED_SCHED_ENABLE
+    led_sched_entry_t entry;
+    bool load = false, set_time = false, run = false;
+#endif
+
+    test_init();
+    lite_led_journal_start(buf, sizeof(buf) / sizeof(buf[0]), NULL);
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        // No step list, no keyframes, paired with itself
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.mode = modes[i];
+        cfg.alter_id = (led_id_e)0;
+        err = lite_led_write(0, &cfg);
+        TEST_CHECK(err != LED_ERROR_NONE, "invalid mode %d write accepted", (int)modes[i]);
+    }
+
+#if LED_SCHED_ENABLE
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = LED_MODE_ON;
+    memset(&entry, 0, sizeof(entry));
+    entry.time_s = 1;
+    entry.action = LED_SCHED_WRITE;
+    entry.id = 3;
+    entry.cfg = &cfg;
+    lite_led_sched_set_time(0, 0);
+    lite_led_sched_load(&entry, 1);
+    for (uint32_t i = 0; i <= 1000 / LED_POLL_PERIOD_MS; i++) {
+        test_poll();
+    }
+    lite_led_sched_load(NULL, 0);
+#endif
+
+    err = lite_led_journal_stop(&count);
+    TEST_CHECK(err == LED_ERROR_NONE, "journal_stop returned %d", err);
+    for (size_t i = 0; i < count; i++) {
+        switch (buf[i].op) {
+            case LED_JOURNAL_INIT:
+                inits++;
+                break;
+#if LED_SCHED_ENABLE
+            case LED_JOURNAL_SCHED_LOAD:
+                load = load || buf[i].arg[0] == 1;
+                break;
+            case LED_JOURNAL_SCHED_TIME:
+                set_time = true;
+                break;
+            case LED_JOURNAL_WRITE:
+                run = buf[i].id == 3 && buf[i].mode == LED_MODE_ON && buf[i].tick != 0;
+                break;
+#endif
+            case LED_JOURNAL_END:
+                break;
+            default:
+                TEST_CHECK(false, "unexpected record op %u for LED %u",
+                           (unsigned)buf[i].op, (unsigned)buf[i].id);
+                break;
+        }
+        TEST_CHECK(lite_led_journal_apply(&buf[i], g_cb[buf[i].id % 16]) == LED_ERROR_NONE,
+                   "record %u does not replay", (unsigned)i);
+    }
+    TEST_CHECK(inits == 16, "%u INIT records", (unsigned)inits);
+#if LED_SCHED_ENABLE
+    TEST_CHECK(load && set_time, "schedule calls not logged");
+    TEST_CHECK(run, "scheduled write not logged");
+#endif
+}
+#endif
+
+int main(int argc, char **argv)
+{
+#if LED_CONTEXT_ENABLE
+    if (argc > 1 && (strcmp(argv[1], "digest") == 0 || strcmp(argv[1], "feature") == 0)) {
+        test_context_fresh();
+    }
+#endif
+    if (argc > 1 && strcmp(argv[1], "digest") == 0) {
+        test_digest();
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "feature") == 0) {
+        test_feature();
+        return 0;
+    }
+#if LED_JOURNAL_ENABLE
+    if (argc > 2 && strcmp(argv[1], "journal") == 0) return test_journal(argv[2]);
+#endif
+    if (argc > 1) {
+        fprintf(stderr, "usage: %s [digest | feature | journal file]\n", argv[0]);
+        return 2;
+    }
+
+#if LED_THERMAL_ENABLE
+    test_thermal();
+#endif
+    test_neutral();
+#if LED_PULL_ENABLE
+    test_pull_follower();
+    test_pull_mirror();
+#endif
+#if LED_GOV_ENABLE
+    test_gov();
+#endif
+#if LED_JOURNAL_ENABLE
+    test_journal_calls();
+#endif
+#if LED_AUTOTUNE_ENABLE
+    test_autotune();
+#endif
+#if LED_CONTEXT_ENABLE
+    test_context();
+#endif
+#if LED_STRIP_ENABLE
+    test_strip();
+#if LED_MASTER_ENABLE
+    test_palette();
+#endif
+#endif
+#if LED_CCT_ENABLE
+    // Leaves entities behind: last
+    test_cct();
+#endif
+
+    if (g_failed != 0) {
+        printf("%lu checks failed\n", g_failed);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#!/bin/sh
+# Lite LED host tests
+#
+# Builds tests/lite_led_test.c once per feature variant, against a copy of
+# inc/lite_led_cfg.h with 16 LEDs, runs the checks of every variant and
+# compares the digests of fixed scenarios between variants:
+#   - each feature alone and all features together must send and report
+#     what the default build does (interpolated output sends more levels,
+#     so only what it reports is compared);
+#   - with each feature in use, a parallel build and a timer-scan build
+#     must send and report what the single-threaded build does;
+#   - a journal recorded on 16 LEDs must replay, pulled, within tolerance;
+#   - the parallel poll benchmark and the site simulation must build and run.
+#
+# Usage: sh tests/run.sh        (CC and CFLAGS are honoured, SANITIZE=0
+#                               skips the sanitizer build)
+
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT INT TERM
+
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:--O2}
+fail=0
+
+# Features switched off by default
+flags=$(tr -d '\r' < "$root/inc/lite_led_cfg.h" | sed -n 's/^#define \(LED_[A-Z_]*_ENABLE\) *(0).*/\1/p')
+
+# cfg <dir> <NAME=value>...: write a 16-LED lite_led_cfg.h with the given settings
+cfg() {
+    dir=$1
+    shift
+    mkdir -p "$dir"
+    cp "$root/inc/lite_led.h" "$dir/"
+    script='s/^    LED_WHITE,$/    LED_WHITE, LED_4, LED_5, LED_6, LED_7, LED_8, LED_9, LED_10, LED_11, LED_12, LED_13, LED_14, LED_15,/'
+    for kv in "$@"; do
+        script="$script
+s/^\(#define ${kv%=*}  *\)([0-9]*)/\1(${kv#*=})/"
+    done
+    tr -d '\r' < "$root/inc/lite_led_cfg.h" | sed "$script" > "$dir/lite_led_cfg.h"
+}
+
+# build <name> <FLAG=value>...: build the test program of a variant and run its checks
+build() {
+    name=$1
+    shift
+    cfg "$work/$name" "$@"
+    $CC -std=c11 $CFLAGS -Wall -Wextra -Werror -I"$work/$name" -o "$work/$name/test" \
+        "$root/tests/lite_led_test.c" "$root/src/lite_led.c" -lm -lpthread
+    if ! "$work/$name/test"; then
+        echo "FAIL $name: checks"
+        fail=1
+    fi
+    "$work/$name/test" digest > "$work/$name/digest"
+    "$work/$name/test" feature > "$work/$name/feature"
+}
+
+# same <name> <reference> <scenario> <line>: compare a digest line of two variants
+same() {
+    a=$(grep "^$4 " "$work/$2/$3")
+    b=$(grep "^$4 " "$work/$1/$3")
+    if [ "$a" != "$b" ]; then
+        echo "FAIL $1: $3 $b, $2 $a"
+        fail=1
+    fi
+}
+
+# threads <name> <FLAG=value>...: build a variant alone, parallel and with the
+# timer scan, and compare what they send
+threads() {
+    ref=$1
+    shift
+    build "$ref" "$@"
+    for t in LED_PARALLEL_ENABLE LED_TIMER_SCAN_ENABLE; do
+        build "$ref+$t" "$@" "$t=1"
+        same "$ref+$t" "$ref" feature sent
+        same "$ref+$t" "$ref" feature state
+    done
+}
+
+# Settings a feature needs or is tested with
+needs() {
+    case $1 in
+        LED_THERMAL_ENABLE) echo LED_MASTER_ENABLE=1 ;;
+        LED_SYNC_ENABLE) echo LED_CLOCK_ENABLE=1 ;;
+        LED_CCT_ENABLE) echo LED_CCT_NUM=2 ;;
+        LED_STRIP_ENABLE) echo LED_STRIP_PORT_WIDTH=16 LED_MASTER_ENABLE=1 ;;
+    esac
+}
+
+build base
+all=
+single=
+for f in $flags; do
+    case $f in
+        LED_PARALLEL_ENABLE | LED_TIMER_SCAN_ENABLE) build "$f" "$f=1" ;;
+        *) threads "$f" "$f=1" $(needs "$f"); single="$single $f=1" ;;
+    esac
+    same "$f" base digest state
+    [ "$f" = LED_OUTPUT_INTERP_ENABLE ] || same "$f" base digest sent
+    all="$all $f=1"
+done
+build all $all
+same all base digest state
+threads single $single
+same all single feature sent
+same all single feature state
+build nolut LED_BREATH_LUT_ENABLE=0
+
+# Every feature under the address and undefined behaviour sanitizers
+if [ "${SANITIZE:-1}" -ne 0 ]; then
+    saved=$CFLAGS
+    CFLAGS="$CFLAGS -g -fsanitize=address,undefined -fno-sanitize-recover=all"
+    build sanitize $all LED_STRIP_PORT_WIDTH=16
+    CFLAGS=$saved
+fi
+
+# Pulled replay of a 16-LED journal
+cfg "$work/replay" LED_JOURNAL_ENABLE=1 LED_SIM_ENABLE=1 LED_PULL_ENABLE=1
+$CC -std=c11 $CFLAGS -Wall -Wextra -Werror -I"$work/replay" -o "$work/replay/test" \
+    "$root/tests/lite_led_test.c" "$root/src/lite_led.c" -lm -lpthread
+$CC -std=c11 $CFLAGS -Wall -Wextra -Werror -I"$work/replay" -o "$work/replay/replay" \
+    "$root/tools/lite_led_replay.c" "$root/src/lite_led.c" -lm
+"$work/replay/test" journal "$work/replay/journal.bin"
+if ! "$work/replay/replay" -p "$work/replay/journal.bin"; then
+    echo "FAIL replay -p"
+    fail=1
+fi
+
+# The benchmark still builds and runs
+if ! LEDS=64 WORKERS=2 CFLAGS="$CFLAGS -Werror" sh "$root/tools/lite_led_bench.sh" -p 100 > "$work/bench.txt"; then
+    echo "FAIL bench"
+    fail=1
+fi
+if ! LEDS=64 WORKERS=2 CFLAGS="$CFLAGS -Werror" sh "$root/tools/lite_led_site.sh" -c 50 -t 20 > "$work/site.txt"; then
+    echo "FAIL site"
+    fail=1
+fi
+
+if [ $fail -ne 0 ]; then
+    echo "TESTS FAILED"
+    exit 1
+fi
+echo "TESTS OK"
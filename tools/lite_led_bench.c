@@ -0,0 +1,229 @@
+/**
+ * @file    lite_led_bench.c
+ * @brief   Lite LED parallel poll benchmark (host tool)
+ *
+ * Measures how evenly the parallel poll spreads a skewed LED population
+ * over real worker threads. The first LEDs breathe, the cost the curve
+ * kernel makes them expensive; the rest are parked ON and nearly free, so
+ * the expensive work sits in the first chunks, the worst case for a
+ * static split. Two schemes run the same polls:
+ *   static  worker w updates a fixed, contiguous share of the chunks
+ *   claim   workers claim chunks from lite_led_poll_work() until none are left
+ * Per scheme, it reports the wall time of a poll (CLOCK_MONOTONIC, from
+ * lite_led_poll_begin() to lite_led_poll_end()), the CPU time each worker
+ * spent on LEDs (CLOCK_THREAD_CPUTIME_ID, less the cost of reading it) and
+ * the balance, the average worker time over the busiest one. Worker 0 is
+ * the polling thread.
+ *
+ * The static split needs the engine's per-LED update, so the engine source
+ * is compiled into the tool. Build with a lite_led_cfg.h that has
+ * LED_PARALLEL_ENABLE and the LED count to measure; tools/lite_led_bench.sh
+ * writes one and runs the benchmark:
+ *   cc -std=c99 -O2 -Iinc -o lite_led_bench tools/lite_led_bench.c -lm -lpthread
+ * Usage:  lite_led_bench [-w workers] [-p polls] [-n hot]
+ *   -w workers  Threads updating LEDs, the polling one included (default 4)
+ *   -p polls    Polls per scheme (default 20000)
+ *   -n hot      Breathing LEDs at the front of the list (default LED_NUM / 8)
+ *
+ * @author  HughWu
+ * @date    2025-08-23
+ * @version 1.0
+ */
+
+#define _POSIX_C_SOURCE 200809L     // pthread_barrier_t, clock_gettime()
+
+#include <pthread.h>
+
+#include "../src/lite_led.c"
+
+#if !LED_PARALLEL_ENABLE
+#error "lite_led_bench needs LED_PARALLEL_ENABLE"
+#endif
+
+#define BENCH_WORKERS_MAX   (64)
+#define BENCH_CHUNKS        ((LED_NUM + LED_PARALLEL_CHUNK - 1) / LED_PARALLEL_CHUNK)
+
+typedef enum {
+    BENCH_STATIC = 0,
+    BENCH_CLAIM,
+
+    BENCH_SCHEME_MAX,
+} bench_scheme_e;
+
+static const char *const g_bench_name[BENCH_SCHEME_MAX] = { "static", "claim" };
+
+static pthread_barrier_t g_bench_start;
+static pthread_barrier_t g_bench_done;
+static bench_scheme_e g_bench_scheme = BENCH_STATIC;
+static bool g_bench_stop = false;
+static size_t g_bench_workers = 4;
+static uint64_t g_bench_cpu_ns[BENCH_WORKERS_MAX];
+static uint64_t g_bench_clock_ns = 0;   // Cost of the two reads that time a worker's part
+
+static void bench_cb(uint8_t percent)
+{
+    (void)percent;
+}
+
+/**
+ * @brief Read a clock in nanoseconds
+ */
+static uint64_t bench_ns(clockid_t id)
+{
+    struct timespec ts;
+
+    clock_gettime(id, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Measure what timing an empty part costs
+ */
+static void bench_calibrate(void)
+{
+    uint64_t start, cost;
+
+    g_bench_clock_ns = UINT64_MAX;
+    for (int i = 0; i < 1000; i++) {
+        start = bench_ns(CLOCK_THREAD_CPUTIME_ID);
+        cost = bench_ns(CLOCK_THREAD_CPUTIME_ID) - start;
+        if (cost < g_bench_clock_ns) g_bench_clock_ns = cost;
+    }
+}
+
+/**
+ * @brief Update the chunks a static split gives to a worker
+ *
+ * Same per-LED work as lite_led_poll_work(), on a fixed range.
+ */
+static void bench_static(size_t w)
+{
+    size_t start = w * BENCH_CHUNKS / g_bench_workers * LED_PARALLEL_CHUNK;
+    size_t end = (w + 1) * BENCH_CHUNKS / g_bench_workers * LED_PARALLEL_CHUNK;
+
+    if (end > LED_NUM) end = LED_NUM;
+    for (size_t i = lite_led_next_due(start); i < end; i = lite_led_next_due(i + 1)) {
+        if (lite_led_is_follower(&g_led_list[i])) continue;
+        lite_led_poll_one((uint8_t)i);
+    }
+}
+
+/**
+ * @brief A worker's part of one poll, timed on its own CPU clock
+ */
+static void bench_work(size_t w)
+{
+    uint64_t start = bench_ns(CLOCK_THREAD_CPUTIME_ID);
+
+    if (g_bench_scheme == BENCH_STATIC) {
+        bench_static(w);
+    } else {
+        while (lite_led_poll_work()) {}
+    }
+    g_bench_cpu_ns[w] += bench_ns(CLOCK_THREAD_CPUTIME_ID) - start - g_bench_clock_ns;
+}
+
+/**
+ * @brief Worker thread: one part per poll until stopped
+ */
+static void *bench_worker(void *arg)
+{
+    size_t w = (size_t)(uintptr_t)arg;
+
+    for (;;) {
+        pthread_barrier_wait(&g_bench_start);
+        if (g_bench_stop) break;
+        bench_work(w);
+        pthread_barrier_wait(&g_bench_done);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Run the polls of a scheme and print what they cost
+ */
+static void bench_run(bench_scheme_e scheme, unsigned long polls)
+{
+    uint64_t wall_ns = 0;
+    uint64_t sum = 0, max = 0;
+    uint64_t start;
+
+    g_bench_scheme = scheme;
+    memset(g_bench_cpu_ns, 0, sizeof(g_bench_cpu_ns));
+
+    for (unsigned long n = 0; n < polls; n++) {
+        start = bench_ns(CLOCK_MONOTONIC);
+        lite_led_poll_begin();
+        pthread_barrier_wait(&g_bench_start);
+        bench_work(0);
+        pthread_barrier_wait(&g_bench_done);
+        lite_led_poll_end();
+        wall_ns += bench_ns(CLOCK_MONOTONIC) - start;
+    }
+
+    printf("%-7s %8.0f ns ", g_bench_name[scheme], (double)wall_ns / polls);
+    for (size_t w = 0; w < g_bench_workers; w++) {
+        printf(" %6.0f", (double)g_bench_cpu_ns[w] / polls);
+        sum += g_bench_cpu_ns[w];
+        if (g_bench_cpu_ns[w] > max) max = g_bench_cpu_ns[w];
+    }
+    printf("   %3.0f%%\n", (max != 0) ? 100.0 * sum / ((double)max * g_bench_workers) : 100.0);
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t thread[BENCH_WORKERS_MAX];
+    unsigned long polls = 20000;
+    size_t hot = LED_NUM / 8;
+    led_cfg_t breath = { .mode = LED_MODE_BREATH };
+    led_cfg_t on = { .mode = LED_MODE_ON };
+    bool usage = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            g_bench_workers = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            polls = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            hot = strtoul(argv[++i], NULL, 0);
+        } else {
+            usage = true;
+        }
+    }
+    if (usage || g_bench_workers == 0 || g_bench_workers > BENCH_WORKERS_MAX || polls == 0 || hot > LED_NUM) {
+        fprintf(stderr, "usage: %s [-w workers] [-p polls] [-n hot]\n", argv[0]);
+        return 2;
+    }
+
+    for (size_t i = 0; i < LED_NUM; i++) {
+        lite_led_init((uint8_t)i, bench_cb);
+        // Different speeds keep the hot LEDs off each other's table entries
+        breath.fade_ms = 1000u + 10u * (uint32_t)i;
+        lite_led_write((uint8_t)i, (i < hot) ? &breath : &on);
+    }
+
+    bench_calibrate();
+    pthread_barrier_init(&g_bench_start, NULL, (unsigned)g_bench_workers);
+    pthread_barrier_init(&g_bench_done, NULL, (unsigned)g_bench_workers);
+    for (size_t w = 1; w < g_bench_workers; w++) {
+        pthread_create(&thread[w], NULL, bench_worker, (void *)(uintptr_t)w);
+    }
+
+    printf("%u LEDs, %u hot, %u chunks of %u, %u workers, %lu polls, %u ns timer cost subtracted\n",
+           (unsigned)LED_NUM, (unsigned)hot, (unsigned)BENCH_CHUNKS, (unsigned)LED_PARALLEL_CHUNK,
+           (unsigned)g_bench_workers, polls, (unsigned)g_bench_clock_ns);
+    printf("scheme  wall/poll   CPU/poll per worker (ns)   balance\n");
+    for (int s = 0; s < BENCH_SCHEME_MAX; s++) {
+        bench_run((bench_scheme_e)s, polls);
+    }
+
+    g_bench_stop = true;
+    pthread_barrier_wait(&g_bench_start);
+    for (size_t w = 1; w < g_bench_workers; w++) {
+        pthread_join(thread[w], NULL);
+    }
+
+    return 0;
+}
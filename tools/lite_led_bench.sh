@@ -0,0 +1,43 @@
+#!/bin/sh
+# Lite LED parallel poll benchmark
+#
+# Writes a copy of inc/lite_led_cfg.h with LEDS LEDs, LED_PARALLEL_ENABLE
+# and the cosine curve kernel (the breathing LEDs then cost what heavier
+# effects would), builds tools/lite_led_bench.c against it and runs it once
+# per worker count. Other arguments go to the benchmark.
+#
+# Usage: sh tools/lite_led_bench.sh [-p polls] [-n hot]
+#        (LEDS=240, WORKERS="1 2 4 8", CHUNK=16, CC and CFLAGS are honoured)
+
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT INT TERM
+
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:--O2}
+LEDS=${LEDS:-240}
+WORKERS=${WORKERS:-1 2 4 8}
+CHUNK=${CHUNK:-16}
+
+ids=
+i=4
+while [ $i -lt "$LEDS" ]; do
+    ids="$ids LED_$i,"
+    i=$((i + 1))
+done
+
+cp "$root/inc/lite_led.h" "$work/"
+tr -d '\r' < "$root/inc/lite_led_cfg.h" | sed \
+    -e "s/^    LED_WHITE,\$/    LED_WHITE,$ids/" \
+    -e 's/^\(#define LED_PARALLEL_ENABLE  *\)([0-9]*)/\1(1)/' \
+    -e "s/^\\(#define LED_PARALLEL_CHUNK  *\\)([0-9]*)/\\1($CHUNK)/" \
+    -e 's/^\(#define LED_BREATH_LUT_ENABLE  *\)([0-9]*)/\1(0)/' > "$work/lite_led_cfg.h"
+$CC -std=c99 $CFLAGS -Wall -Wextra -I"$work" -o "$work/bench" "$root/tools/lite_led_bench.c" -lm -lpthread
+
+echo "$(nproc 2>/dev/null || echo '?') CPUs online"
+for w in $WORKERS; do
+    "$work/bench" -w "$w" "$@"
+    echo
+done
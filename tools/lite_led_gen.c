@@ -0,0 +1,576 @@
+/**
+ * @file    lite_led_gen.c
+ * @brief   Lite LED offline scene compiler (host tool)
+ *
+ * Turns a fixed scene description into C source with const per-poll
+ * brightness tables and a poll routine unrolled for the actual LEDs, for
+ * products whose LED behavior is known at build time. Only the code for
+ * the modes in the scene is emitted; lite_led.c is not needed at runtime.
+ *
+ * Build:  cc -std=c99 -O2 -o lite_led_gen tools/lite_led_gen.c -lm
+ * Usage:  lite_led_gen scene.txt out      (writes out.h and out.c)
+ *
+ * Scene description, one statement per line, '#' starts a comment:
+ *   period <ms>                      Poll period (default 100)
+ *   curve lut|cos                    Breath curve, as LED_BREATH_LUT_ENABLE (default lut)
+ *   led <NAME> on|off                [dur=<ms>]
+ *   led <NAME> blink on=<ms> off=<ms> [dur=<ms>]
+ *   led <NAME> breath|fade_in|fade_out fade=<ms> [dur=<ms>]
+ *   led <NAME> alternate alt=<NAME> ms=<ms> [dur=<ms>]
+ *
+ * The generated led_gen_poll() issues the callbacks lite_led_poll_handle()
+ * would for the same lite_led_write() calls, on the same polls, with the
+ * same values. Fades are tables; a breath cycle is in general not a whole
+ * number of polls, so its phase is accumulated in float exactly as the
+ * engine does and looked up in the same curve.
+ *
+ * @author  HughWu
+ * @date    2025-08-23
+ * @version 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define GEN_LED_MAX     64
+#define GEN_NAME_LEN    32
+#define GEN_LINE_LEN    256
+#define GEN_TABLE_MAX   4096    // Longest curve table (polls)
+
+typedef enum {
+    GEN_MODE_OFF = 0,
+    GEN_MODE_ON,
+    GEN_MODE_BLINK,
+    GEN_MODE_BREATH,
+    GEN_MODE_FADE_IN,
+    GEN_MODE_FADE_OUT,
+    GEN_MODE_ALTERNATE,
+} gen_mode_e;
+
+typedef struct {
+    char name[GEN_NAME_LEN];
+    gen_mode_e mode;
+    uint32_t on_ms;
+    uint32_t off_ms;
+    uint32_t fade_ms;
+    uint32_t alternate_ms;
+    uint32_t duration_ms;
+    char alt_name[GEN_NAME_LEN];
+    int alt;                // Index of the alternate partner, -1 = none
+} gen_led_t;
+
+static const char *const g_mode_name[] = {
+    "OFF", "ON", "BLINK", "BREATH", "FADE_IN", "FADE_OUT", "ALTERNATE",
+};
+
+// Same table as lite_led.c, LED_BREATH_LUT_ENABLE
+#define GEN_TABLE_SIZE 128
+static const uint8_t g_sin_table[GEN_TABLE_SIZE + 1] = {
+    0,  1,  2,  3,  4,  5,  7,  8, 10, 11, 13, 15, 16, 18, 20, 22,
+   24, 26, 28, 30, 32, 34, 37, 39, 41, 44, 46, 49, 51, 54, 56, 59,
+   61, 64, 67, 69, 72, 75, 77, 80, 83, 86, 88, 91, 94, 97,100,100,
+  100,100,100,100,100,100,100,100,100,100,100,100,100,100,100,100,
+  100,100,100,100,100,100,100,100,100,100,100,100,100,100,100,100,
+   97, 94, 91, 88, 86, 83, 80, 77, 75, 72, 69, 67, 64, 61, 59, 56,
+   54, 51, 49, 46, 44, 41, 39, 37, 34, 32, 30, 28, 26, 24, 22, 20,
+   18, 16, 15, 13, 11, 10,  8,  7,  5,  4,  3,  2,  1,  0,  0,  0
+};
+
+static gen_led_t g_led[GEN_LED_MAX];
+static int g_led_num = 0;
+static uint32_t g_period_ms = 100;
+static bool g_curve_lut = true;
+
+/**
+ * @brief Brightness of a breath/fade phase, as lite_led_curve()
+ */
+static uint8_t gen_curve(float phase)
+{
+    uint8_t percent;
+
+    if (g_curve_lut) {
+        float step = (float)(2.0 * M_PI) / GEN_TABLE_SIZE;
+        size_t index = (size_t)(phase / step);
+        if (index > GEN_TABLE_SIZE) index = GEN_TABLE_SIZE;
+        percent = g_sin_table[index];
+    } else {
+        percent = (uint8_t)((1 - cos(phase)) / 2.0 * 100);
+    }
+    if (percent >= 100) percent = 100;
+
+    return percent;
+}
+
+/**
+ * @brief Parse "key=<ms>" into *value if the token has that key
+ *
+ * @return int 1 if matched, 0 if another key, -1 on a bad number
+ */
+static int gen_parse_ms(const char *tok, const char *key, uint32_t *value)
+{
+    size_t len = strlen(key);
+    char *end;
+    unsigned long v;
+
+    if (strncmp(tok, key, len) != 0 || tok[len] != '=') return 0;
+    v = strtoul(tok + len + 1, &end, 10);
+    if (*end != '\0' || end == tok + len + 1) return -1;
+    *value = (uint32_t)v;
+
+    return 1;
+}
+
+/**
+ * @brief Parse one "led" statement
+ *
+ * @return int 0 on success, -1 on error (reported)
+ */
+static int gen_parse_led(char *args, const char *file, int line)
+{
+    static const char *const modes[] = {
+        "off", "on", "blink", "breath", "fade_in", "fade_out", "alternate",
+    };
+    gen_led_t *led;
+    char *tok;
+    int ret;
+
+    if (g_led_num >= GEN_LED_MAX) {
+        fprintf(stderr, "%s:%d: more than %d LEDs\n", file, line, GEN_LED_MAX);
+        return -1;
+    }
+    led = &g_led[g_led_num];
+    memset(led, 0, sizeof(*led));
+    led->alt = -1;
+
+    tok = strtok(args, " \t");
+    if (tok == NULL || strlen(tok) >= GEN_NAME_LEN || !(isalpha((unsigned char)tok[0]) || tok[0] == '_')) {
+        fprintf(stderr, "%s:%d: missing or bad LED name\n", file, line);
+        return -1;
+    }
+    strcpy(led->name, tok);
+    for (int i = 0; i < g_led_num; i++) {
+        if (strcmp(g_led[i].name, led->name) == 0) {
+            fprintf(stderr, "%s:%d: LED %s defined twice\n", file, line, led->name);
+            return -1;
+        }
+    }
+
+    tok = strtok(NULL, " \t");
+    for (ret = 0; tok != NULL && ret < (int)(sizeof(modes) / sizeof(modes[0])); ret++) {
+        if (strcmp(tok, modes[ret]) == 0) break;
+    }
+    if (tok == NULL || ret == (int)(sizeof(modes) / sizeof(modes[0]))) {
+        fprintf(stderr, "%s:%d: unknown mode %s\n", file, line, tok ? tok : "(none)");
+        return -1;
+    }
+    led->mode = (gen_mode_e)ret;
+
+    while ((tok = strtok(NULL, " \t")) != NULL) {
+        if (strncmp(tok, "alt=", 4) == 0 && strlen(tok + 4) < GEN_NAME_LEN) {
+            strcpy(led->alt_name, tok + 4);
+            continue;
+        }
+        ret = gen_parse_ms(tok, "on", &led->on_ms);
+        if (ret == 0) ret = gen_parse_ms(tok, "off", &led->off_ms);
+        if (ret == 0) ret = gen_parse_ms(tok, "fade", &led->fade_ms);
+        if (ret == 0) ret = gen_parse_ms(tok, "ms", &led->alternate_ms);
+        if (ret == 0) ret = gen_parse_ms(tok, "dur", &led->duration_ms);
+        if (ret != 1) {
+            fprintf(stderr, "%s:%d: bad parameter %s\n", file, line, tok);
+            return -1;
+        }
+    }
+
+    if ((led->mode == GEN_MODE_BREATH || led->mode == GEN_MODE_FADE_IN || led->mode == GEN_MODE_FADE_OUT) &&
+        led->fade_ms < g_period_ms) {
+        fprintf(stderr, "%s:%d: fade= must be at least one period\n", file, line);
+        return -1;
+    }
+    if (led->mode == GEN_MODE_ALTERNATE && led->alt_name[0] == '\0') {
+        fprintf(stderr, "%s:%d: alternate needs alt=<NAME>\n", file, line);
+        return -1;
+    }
+
+    g_led_num++;
+    return 0;
+}
+
+/**
+ * @brief Read the scene description
+ *
+ * @return int 0 on success, -1 on error (reported)
+ */
+static int gen_parse(const char *file)
+{
+    char buf[GEN_LINE_LEN];
+    char empty[1] = "";
+    char *p, *tok;
+    FILE *fp;
+    int line = 0;
+    int err = 0;
+
+    fp = fopen(file, "r");
+    if (fp == NULL) {
+        perror(file);
+        return -1;
+    }
+
+    while (fgets(buf, sizeof(buf), fp) != NULL) {
+        line++;
+        p = strchr(buf, '#');
+        if (p != NULL) *p = '\0';
+        p = buf + strlen(buf);
+        while (p > buf && isspace((unsigned char)p[-1])) *--p = '\0';
+
+        tok = strtok(buf, " \t");
+        if (tok == NULL) continue;
+        if (strcmp(tok, "led") == 0) {
+            p = strtok(NULL, "");
+            if (gen_parse_led(p ? p : empty, file, line) != 0) err = -1;
+        } else if (strcmp(tok, "period") == 0) {
+            tok = strtok(NULL, " \t");
+            g_period_ms = tok ? (uint32_t)strtoul(tok, NULL, 10) : 0;
+            if (g_period_ms == 0) {
+                fprintf(stderr, "%s:%d: bad period\n", file, line);
+                err = -1;
+            }
+        } else if (strcmp(tok, "curve") == 0) {
+            tok = strtok(NULL, " \t");
+            if (tok != NULL && strcmp(tok, "lut") == 0) {
+                g_curve_lut = true;
+            } else if (tok != NULL && strcmp(tok, "cos") == 0) {
+                g_curve_lut = false;
+            } else {
+                fprintf(stderr, "%s:%d: curve must be lut or cos\n", file, line);
+                err = -1;
+            }
+        } else {
+            fprintf(stderr, "%s:%d: unknown statement %s\n", file, line, tok);
+            err = -1;
+        }
+    }
+    fclose(fp);
+
+    // Resolve alternate partners
+    for (int i = 0; i < g_led_num && err == 0; i++) {
+        if (g_led[i].mode != GEN_MODE_ALTERNATE) continue;
+        for (int j = 0; j < g_led_num; j++) {
+            if (strcmp(g_led[j].name, g_led[i].alt_name) == 0) g_led[i].alt = j;
+        }
+        if (g_led[i].alt < 0 || g_led[i].alt == i || g_led[g_led[i].alt].mode != GEN_MODE_ALTERNATE) {
+            fprintf(stderr, "%s: LED %s: partner %s must be another alternate LED\n",
+                    file, g_led[i].name, g_led[i].alt_name);
+            err = -1;
+        }
+    }
+    if (err == 0 && g_led_num == 0) {
+        fprintf(stderr, "%s: no LEDs\n", file);
+        err = -1;
+    }
+
+    return err;
+}
+
+/**
+ * @brief Phase step per poll of a breath/fade LED, as lite_led_write()
+ */
+static float gen_phase_step(const gen_led_t *led)
+{
+    return (float)M_PI * g_period_ms / (float)led->fade_ms;
+}
+
+/**
+ * @brief Compute the per-poll values of a fade LED
+ *
+ * The table ends on the final value, as the engine parks the LED there.
+ *
+ * @return size_t Number of values, 0 if the table would be too long
+ */
+static size_t gen_curve_table(const gen_led_t *led, uint8_t *table)
+{
+    float step = gen_phase_step(led);
+    float phase;
+    size_t n;
+
+    // Same float accumulation and end tests as the engine, so a fade lasts
+    // exactly as many polls
+    phase = (led->mode == GEN_MODE_FADE_OUT) ? (float)M_PI : 0.0f;
+    for (n = 0; n < GEN_TABLE_MAX; n++) {
+        if (led->mode == GEN_MODE_FADE_IN) {
+            phase += step;
+            if (phase >= M_PI) {
+                table[n] = gen_curve((float)M_PI);
+                return n + 1;
+            }
+        } else {
+            phase -= step;
+            if (phase <= 0.0f) {
+                table[n] = gen_curve(0.0f);
+                return n + 1;
+            }
+        }
+        table[n] = gen_curve(phase);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Write the curve lookup used by breath LEDs, as lite_led_curve()
+ */
+static void gen_emit_curve(FILE *fp)
+{
+    if (g_curve_lut) {
+        fprintf(fp, "static const uint8_t s_lut[%d] = {", GEN_TABLE_SIZE + 1);
+        for (size_t i = 0; i <= GEN_TABLE_SIZE; i++) {
+            fprintf(fp, "%s%3u,", (i % 16 == 0) ? "\n    " : " ", g_sin_table[i]);
+        }
+        fprintf(fp, "\n};\n\n");
+        fprintf(fp, "static uint8_t led_gen_curve(float phase)\n{\n");
+        fprintf(fp, "    size_t index = (size_t)(phase / %af);\n\n", (float)(2.0 * M_PI) / GEN_TABLE_SIZE);
+        fprintf(fp, "    return s_lut[(index > %d) ? %d : index];\n}\n\n", GEN_TABLE_SIZE, GEN_TABLE_SIZE);
+    } else {
+        fprintf(fp, "static uint8_t led_gen_curve(float phase)\n{\n");
+        fprintf(fp, "    uint8_t percent = (uint8_t)((1 - cos(phase)) / 2.0 * 100);\n\n");
+        fprintf(fp, "    return (percent >= 100) ? 100 : percent;\n}\n\n");
+    }
+}
+
+/**
+ * @brief Write a const table
+ */
+static void gen_emit_table(FILE *fp, const char *name, const uint8_t *table, size_t n)
+{
+    fprintf(fp, "static const uint8_t %s[%zu] = {", name, n);
+    for (size_t i = 0; i < n; i++) {
+        fprintf(fp, "%s%3u,", (i % 16 == 0) ? "\n    " : " ", table[i]);
+    }
+    fprintf(fp, "\n};\n\n");
+}
+
+static uint32_t gen_ticks(uint32_t ms)
+{
+    return ms / g_period_ms;
+}
+
+/**
+ * @brief Write the generated header
+ */
+static int gen_emit_header(const char *path, const char *guard)
+{
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    fprintf(fp, "/* Generated by lite_led_gen, do not edit */\n\n");
+    fprintf(fp, "#ifndef %s\n#define %s\n\n", guard, guard);
+    fprintf(fp, "#include <stdint.h>\n\n");
+    fprintf(fp, "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n");
+    fprintf(fp, "#define LED_GEN_PERIOD_MS   (%u)\n", (unsigned)g_period_ms);
+    fprintf(fp, "#define LED_GEN_NUM         (%d)\n\n", g_led_num);
+    fprintf(fp, "typedef enum {\n");
+    for (int i = 0; i < g_led_num; i++) fprintf(fp, "    LED_GEN_%s = %d,\n", g_led[i].name, i);
+    fprintf(fp, "} led_gen_id_e;\n\n");
+    fprintf(fp, "typedef void (*led_gen_set_f)(uint8_t percent);\n\n");
+    fprintf(fp, "void led_gen_init(const led_gen_set_f cb[LED_GEN_NUM]);\n");
+    fprintf(fp, "void led_gen_poll(void);   // Call every LED_GEN_PERIOD_MS\n\n");
+    fprintf(fp, "#ifdef __cplusplus\n}\n#endif\n\n#endif // %s\n", guard);
+
+    fclose(fp);
+    return 0;
+}
+
+/**
+ * @brief Write the mode logic of one LED into led_gen_poll()
+ */
+static void gen_emit_mode(FILE *fp, int i, const char *indent)
+{
+    const gen_led_t *led = &g_led[i];
+    uint32_t t_on = gen_ticks(led->on_ms);
+    uint32_t t_off = gen_ticks(led->off_ms);
+    uint32_t t_alt = gen_ticks(led->alternate_ms);
+
+    switch (led->mode) {
+        case GEN_MODE_OFF:
+        case GEN_MODE_ON:
+            fprintf(fp, "%sif (s_next_%d == 0) {\n", indent, i);
+            fprintf(fp, "%s    s_next_%d = 1;\n", indent, i);
+            fprintf(fp, "%s    s_state_%d = %d;\n", indent, i, led->mode == GEN_MODE_ON);
+            fprintf(fp, "%s    s_cb[%d](%d);\n", indent, i, led->mode == GEN_MODE_ON ? 100 : 0);
+            fprintf(fp, "%s}\n", indent);
+            break;
+        case GEN_MODE_BLINK:
+            // next_tick countdown as the engine: a zero reload runs every poll
+            fprintf(fp, "%sif (s_next_%d == 0 || --s_next_%d == 0) {\n", indent, i, i);
+            fprintf(fp, "%s    s_state_%d = !s_state_%d;\n", indent, i, i);
+            fprintf(fp, "%s    s_next_%d = s_state_%d ? %uu : %uu;\n", indent, i, i, (unsigned)t_on, (unsigned)t_off);
+            fprintf(fp, "%s    s_cb[%d](s_state_%d ? 100 : 0);\n", indent, i, i);
+            fprintf(fp, "%s}\n", indent);
+            break;
+        case GEN_MODE_BREATH:
+            // Float step, wrap in double: the engine's exact operations
+            fprintf(fp, "%ss_phase_%d += %af;\n", indent, i, gen_phase_step(led));
+            fprintf(fp, "%sif (s_phase_%d >= %.17g) s_phase_%d -= %.17g;\n", indent, i, 2.0 * M_PI, i, 2.0 * M_PI);
+            fprintf(fp, "%ss_cb[%d](led_gen_curve(s_phase_%d));\n", indent, i, i);
+            break;
+        case GEN_MODE_FADE_IN:
+        case GEN_MODE_FADE_OUT:
+            fprintf(fp, "%sif (s_pos_%d < sizeof(s_curve_%d)) {\n", indent, i, i);
+            fprintf(fp, "%s    s_cb[%d](s_curve_%d[s_pos_%d++]);\n", indent, i, i, i);
+            fprintf(fp, "%s}\n", indent);
+            break;
+        case GEN_MODE_ALTERNATE:
+            fprintf(fp, "%sif (s_next_%d == 0 || --s_next_%d == 0) {\n", indent, i, i);
+            if (i < led->alt) {
+                fprintf(fp, "%s    s_state_%d = !s_state_%d;\n", indent, i, i);
+            } else {
+                fprintf(fp, "%s    s_state_%d = !s_state_%d;\n", indent, i, led->alt);
+            }
+            fprintf(fp, "%s    s_next_%d = %uu;\n", indent, i, (unsigned)t_alt);
+            fprintf(fp, "%s    s_cb[%d](s_state_%d ? 100 : 0);\n", indent, i, i);
+            fprintf(fp, "%s}\n", indent);
+            break;
+    }
+}
+
+/**
+ * @brief Write the generated source
+ */
+static int gen_emit_source(const char *path, const char *header)
+{
+    uint8_t table[GEN_TABLE_MAX];
+    char name[GEN_NAME_LEN + 16];
+    const gen_led_t *led;
+    bool breath = false;
+    FILE *fp;
+    size_t n;
+
+    for (int i = 0; i < g_led_num; i++) {
+        if (g_led[i].mode == GEN_MODE_BREATH) breath = true;
+    }
+
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    fprintf(fp, "/* Generated by lite_led_gen, do not edit */\n\n");
+    fprintf(fp, "#include <stddef.h>\n");
+    if (breath && !g_curve_lut) fprintf(fp, "#include <math.h>\n");
+    fprintf(fp, "#include \"%s\"\n\n", header);
+    fprintf(fp, "static led_gen_set_f s_cb[LED_GEN_NUM];\n\n");
+    if (breath) gen_emit_curve(fp);
+
+    for (int i = 0; i < g_led_num; i++) {
+        led = &g_led[i];
+        if (led->mode != GEN_MODE_FADE_IN && led->mode != GEN_MODE_FADE_OUT) continue;
+        n = gen_curve_table(led, table);
+        if (n == 0) {
+            fprintf(stderr, "LED %s: curve longer than %d polls\n", led->name, GEN_TABLE_MAX);
+            fclose(fp);
+            return -1;
+        }
+        fprintf(fp, "// %s: %s, %zu polls\n", led->name, g_mode_name[led->mode], n);
+        snprintf(name, sizeof(name), "s_curve_%d", i);
+        gen_emit_table(fp, name, table, n);
+    }
+
+    // Per-LED state, only what the mode needs
+    for (int i = 0; i < g_led_num; i++) {
+        led = &g_led[i];
+        switch (led->mode) {
+            case GEN_MODE_BREATH:
+                fprintf(fp, "static float s_phase_%d;\n", i);
+                break;
+            case GEN_MODE_FADE_IN:
+            case GEN_MODE_FADE_OUT:
+                fprintf(fp, "static uint16_t s_pos_%d;\n", i);
+                break;
+            default:
+                fprintf(fp, "static uint32_t s_next_%d;\n", i);
+                fprintf(fp, "static uint8_t s_state_%d;\n", i);
+                break;
+        }
+        if (gen_ticks(led->duration_ms) != 0) fprintf(fp, "static uint32_t s_poll_%d;\n", i);
+    }
+
+    fprintf(fp, "\nvoid led_gen_init(const led_gen_set_f cb[LED_GEN_NUM])\n{\n");
+    fprintf(fp, "    for (size_t i = 0; i < LED_GEN_NUM; i++) s_cb[i] = cb[i];\n}\n\n");
+
+    fprintf(fp, "void led_gen_poll(void)\n{\n");
+    for (int i = 0; i < g_led_num; i++) {
+        led = &g_led[i];
+        fprintf(fp, "    // %s: %s\n", led->name, g_mode_name[led->mode]);
+        if (gen_ticks(led->duration_ms) == 0) {
+            gen_emit_mode(fp, i, "    ");
+        } else {
+            // The effect runs for duration - 1 polls, then turns off one poll later
+            uint32_t d = gen_ticks(led->duration_ms);
+
+            fprintf(fp, "    if (s_poll_%d + 1 < %uu) {\n", i, (unsigned)d);
+            gen_emit_mode(fp, i, "        ");
+            fprintf(fp, "    } else if (s_poll_%d == %uu) {\n", i, (unsigned)d);
+            if (led->mode != GEN_MODE_BREATH && led->mode != GEN_MODE_FADE_IN && led->mode != GEN_MODE_FADE_OUT) {
+                fprintf(fp, "        s_state_%d = 0;\n", i);
+            }
+            fprintf(fp, "        s_cb[%d](0);\n", i);
+            fprintf(fp, "    }\n");
+            fprintf(fp, "    if (s_poll_%d <= %uu) s_poll_%d++;\n", i, (unsigned)d, i);
+        }
+    }
+    fprintf(fp, "}\n");
+
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    char h_path[512], c_path[512], guard[256];
+    const char *base;
+    size_t j = 0;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s scene.txt out\n", argv[0]);
+        return 2;
+    }
+    if (strlen(argv[2]) + 3 > sizeof(h_path)) {
+        fprintf(stderr, "output name too long\n");
+        return 2;
+    }
+    if (gen_parse(argv[1]) != 0) return 1;
+
+    snprintf(h_path, sizeof(h_path), "%s.h", argv[2]);
+    snprintf(c_path, sizeof(c_path), "%s.c", argv[2]);
+
+    // Include by file name, guard from it in upper case
+    base = strrchr(h_path, '/');
+    base = base ? base + 1 : h_path;
+    guard[j++] = '_';
+    guard[j++] = '_';
+    for (const char *p = base; *p != '\0' && j + 3 < sizeof(guard); p++) {
+        guard[j++] = isalnum((unsigned char)*p) ? (char)toupper((unsigned char)*p) : '_';
+    }
+    guard[j++] = '_';
+    guard[j++] = '_';
+    guard[j] = '\0';
+
+    if (gen_emit_header(h_path, guard) != 0) return 1;
+    if (gen_emit_source(c_path, base) != 0) return 1;
+
+    return 0;
+}
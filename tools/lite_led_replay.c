@@ -0,0 +1,373 @@
+/**
+ * @file    lite_led_replay.c
+ * @brief   Lite LED journal replay (host tool)
+ *
+ * Feeds a journal recorded with LED_JOURNAL_ENABLE back through the
+ * simulator. Every record is applied before the poll it was logged for,
+ * so the engine goes through the states it went through on the device.
+ * The engine digests the levels it sends to the backends; at the end of
+ * the recording the digest must match the one the device stored in the
+ * END record, and calls the device logged as UNSUPPORTED fail the replay.
+ * With -r the journal is replayed back to back and the throughput is
+ * reported, so production command streams double as load tests. With -p
+ * the journal is also replayed with every LED in pull mode, and the levels
+ * lite_led_read() gives after each poll must match the pushed ones.
+ *
+ * Build with the device's lite_led_cfg.h, plus LED_JOURNAL_ENABLE and
+ * LED_SIM_ENABLE:
+ *   cc -std=c99 -O2 -Iinc -o lite_led_replay tools/lite_led_replay.c src/lite_led.c -lm
+ * Usage:  lite_led_replay [-v] [-p] [-r runs] [-t ticks] journal.bin
+ *   -v          Print every poll: tick, digest and LED levels
+ *   -p          Check pull mode against push mode (needs LED_PULL_ENABLE)
+ *   -r runs     Replay the journal this many times (default 1)
+ *   -t ticks    Polls to run after the last record if the journal has no
+ *               END record (default 0)
+ *
+ * @author  HughWu
+ * @date    2025-08-23
+ * @version 1.0
+ */
+
+#define _POSIX_C_SOURCE 200809L     // fork() and pipe() for -p
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "lite_led.h"
+
+#if !LED_JOURNAL_ENABLE || !LED_SIM_ENABLE
+#error "lite_led_replay needs LED_JOURNAL_ENABLE and LED_SIM_ENABLE"
+#endif
+
+#define REPLAY_PULL_TOL     (3)     // Pull/push difference allowed: the largest step between neighbouring breath table entries
+#define REPLAY_SHOW_MAX     (8)     // Records reported one by one before going quiet
+
+static led_journal_rec_t *g_rec = NULL;
+static size_t g_rec_num = 0;
+static uint8_t *g_push = NULL;      // Pushed levels of every poll of the first run, for -p
+static uint8_t *g_pull = NULL;      // Pulled levels of every poll, for -p
+
+/**
+ * @brief Read a whole journal file
+ */
+static int replay_load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    long size;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0) {
+        perror(path);
+        fclose(f);
+        return -1;
+    }
+    if (size == 0 || (size_t)size % sizeof(led_journal_rec_t) != 0) {
+        fprintf(stderr, "%s: not a journal of %u-byte records\n", path, (unsigned)sizeof(led_journal_rec_t));
+        fclose(f);
+        return -1;
+    }
+
+    g_rec_num = (size_t)size / sizeof(led_journal_rec_t);
+    g_rec = malloc((size_t)size);
+    if (g_rec == NULL || fread(g_rec, sizeof(led_journal_rec_t), g_rec_num, f) != g_rec_num) {
+        fprintf(stderr, "%s: read failed\n", path);
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    for (size_t i = 1; i < g_rec_num; i++) {
+        if (g_rec[i].tick < g_rec[i - 1].tick) {
+            fprintf(stderr, "%s: record %u goes back in time\n", path, (unsigned)i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Backend of the replayed LEDs: the engine digests what it sends
+ */
+static void replay_cb(uint8_t percent)
+{
+    (void)percent;
+}
+
+/**
+ * @brief Run one poll, with the output-rate steps the device runs between polls
+ */
+static void replay_poll(void)
+{
+    lite_led_sim_run(1, NULL);
+#if LED_OUTPUT_INTERP_ENABLE
+    for (uint32_t i = 0; i < LED_POLL_PERIOD_MS / LED_OUTPUT_PERIOD_MS; i++) {
+        lite_led_output_poll();
+    }
+#endif
+}
+
+/**
+ * @brief Read the level of every LED
+ */
+static void replay_levels(bool print, uint8_t *save)
+{
+    led_status_t status;
+
+    for (uint8_t id = 0; id < LED_NUM; id++) {
+        lite_led_read(id, &status);
+        if (print) printf(" %3u", (unsigned)status.percent);
+        if (save != NULL) save[id] = status.percent;
+    }
+}
+
+#if LED_PULL_ENABLE
+/**
+ * @brief Replay the journal with every LED in pull mode
+ *
+ * Runs in a child forked before anything was replayed, as the engine has
+ * no reset; the levels of every poll go back to the parent through fd.
+ */
+static void replay_pull_run(uint32_t end, int fd)
+{
+    uint8_t levels[LED_NUM];
+    size_t next = 0;
+    size_t done;
+    ssize_t n;
+
+    for (uint32_t tick = 0; tick < end; tick++) {
+        for (; next < g_rec_num && g_rec[next].tick == tick; next++) {
+            if (g_rec[next].op == LED_JOURNAL_PULL) continue;
+            lite_led_journal_apply(&g_rec[next], replay_cb);
+            if (g_rec[next].op == LED_JOURNAL_INIT) lite_led_set_pull(g_rec[next].id, true);
+        }
+        replay_poll();
+        replay_levels(false, levels);
+
+        for (done = 0; done < LED_NUM; done += (size_t)n) {
+            n = write(fd, levels + done, LED_NUM - done);
+            if (n <= 0) return;
+        }
+    }
+}
+
+/**
+ * @brief Get the pulled levels of every poll from a fresh replay
+ *
+ * @return int 0 on success
+ */
+static int replay_pull_levels(uint32_t end)
+{
+    size_t total = (size_t)end * LED_NUM;
+    size_t got = 0;
+    ssize_t n;
+    pid_t pid;
+    int fd[2];
+    int status;
+
+    if (pipe(fd) != 0) {
+        perror("pipe");
+        return -1;
+    }
+    fflush(stdout);
+    pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        close(fd[0]);
+        replay_pull_run(end, fd[1]);
+        _exit(0);
+    }
+
+    close(fd[1]);
+    while (got < total && (n = read(fd[0], g_pull + got, total - got)) > 0) {
+        got += (size_t)n;
+    }
+    close(fd[0]);
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || got != total) {
+        fprintf(stderr, "pull replay failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Compare the pulled levels with the pushed ones
+ *
+ * @return Number of LED levels off by more than REPLAY_PULL_TOL
+ */
+static unsigned long replay_pull_check(uint32_t end)
+{
+    unsigned long differ = 0;
+    unsigned diff, max = 0;
+
+    for (size_t i = 0; i < (size_t)end * LED_NUM; i++) {
+        diff = (g_pull[i] > g_push[i]) ? (unsigned)(g_pull[i] - g_push[i]) : (unsigned)(g_push[i] - g_pull[i]);
+        if (diff > max) max = diff;
+        if (diff <= REPLAY_PULL_TOL) continue;
+        if (differ++ == 0) {
+            printf("pull check: tick %u LED %u push %u pull %u\n", (unsigned)(i / LED_NUM),
+                   (unsigned)(i % LED_NUM), (unsigned)g_push[i], (unsigned)g_pull[i]);
+        }
+    }
+
+    printf("pull check: %lu of %lu levels differ by more than %u (max %u)\n", differ,
+           (unsigned long)end * LED_NUM, (unsigned)REPLAY_PULL_TOL, max);
+
+    return differ;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    bool verbose = false;
+    bool pull = false;
+    bool has_end;
+    unsigned long runs = 1;
+    unsigned long tail = 0;
+    uint32_t end;
+    uint32_t digest = 0;
+    unsigned long failed = 0;
+    unsigned long unsupported = 0;
+    led_stats_t before, after;
+    clock_t start;
+    double wall_s;
+    size_t next;
+    int err;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[i], "-p") == 0) {
+            pull = true;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            runs = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            tail = strtoul(argv[++i], NULL, 0);
+        } else if (path == NULL && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if (path == NULL || runs == 0) {
+        fprintf(stderr, "usage: %s [-v] [-p] [-r runs] [-t ticks] journal.bin\n", argv[0]);
+        return 2;
+    }
+#if !LED_PULL_ENABLE
+    if (pull) {
+        fprintf(stderr, "-p needs LED_PULL_ENABLE\n");
+        return 2;
+    }
+#endif
+    if (replay_load(path) != 0) return 1;
+
+    // The recording ends at its END record, or after the last recorded poll
+    has_end = (g_rec[g_rec_num - 1].op == LED_JOURNAL_END);
+    if (has_end) {
+        end = g_rec[g_rec_num - 1].tick;
+    } else {
+        end = g_rec[g_rec_num - 1].tick + 1 + (uint32_t)tail;
+    }
+#if LED_PULL_ENABLE
+    if (pull) {
+        g_push = malloc((size_t)end * LED_NUM);
+        g_pull = malloc((size_t)end * LED_NUM);
+        if (g_push == NULL || g_pull == NULL) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        if (replay_pull_levels(end) != 0) return 1;
+    }
+#endif
+
+    lite_led_get_stats(&before);
+    start = clock();
+
+    for (unsigned long run = 0; run < runs; run++) {
+        next = 0;
+        for (uint32_t tick = 0; tick < end;) {
+            uint32_t until = end;
+
+            for (; next < g_rec_num && g_rec[next].tick == tick; next++) {
+                err = lite_led_journal_apply(&g_rec[next], replay_cb);
+                if (err == LED_ERROR_NOT_REPLAYABLE) {
+                    if (run == 0 && unsupported++ < REPLAY_SHOW_MAX) {
+                        printf("record %u, tick %u: call %u on %u cannot be replayed\n", (unsigned)next,
+                               (unsigned)tick, (unsigned)g_rec[next].arg[0], (unsigned)g_rec[next].id);
+                    }
+                } else if (err != LED_ERROR_NONE) {
+                    failed++;
+                }
+            }
+            if (next < g_rec_num && g_rec[next].tick < end) until = g_rec[next].tick;
+
+            // Only the first run is checked poll by poll; the others run the
+            // stretches between records in one go
+            if (run == 0) {
+                replay_poll();
+                if (verbose) {
+                    lite_led_get_stats(&after);
+                    printf("%8u  %08x", (unsigned)tick, (unsigned)after.journal_digest);
+                }
+                replay_levels(verbose, pull ? &g_push[(size_t)tick * LED_NUM] : NULL);
+                if (verbose) printf("\n");
+                tick++;
+            } else {
+                lite_led_sim_run(until - tick, NULL);
+                tick = until;
+            }
+        }
+        if (run == 0) {
+            lite_led_get_stats(&after);
+            digest = after.journal_digest;
+        }
+    }
+
+    wall_s = (double)(clock() - start) / CLOCKS_PER_SEC;
+    lite_led_get_stats(&after);
+
+    printf("records %u, failed %lu, not replayable %lu, polls %u x %lu\n", (unsigned)g_rec_num, failed,
+           unsupported, (unsigned)end, runs);
+    if (has_end) {
+        printf("digest %08x, recorded %08x\n", (unsigned)digest, (unsigned)g_rec[g_rec_num - 1].arg[0]);
+        if (digest != g_rec[g_rec_num - 1].arg[0]) {
+            printf("replay sent other levels than the device\n");
+            failed++;
+        }
+    } else {
+        printf("digest %08x (no END record to check it against)\n", (unsigned)digest);
+    }
+    if (wall_s > 0.0) {
+        printf("%.1f ms simulated in %.3f s: %.0f polls/s, %.0f updates/s, %.0fx real time\n",
+               (double)end * runs * LED_POLL_PERIOD_MS, wall_s, (double)end * runs / wall_s,
+               (double)(after.update_count - before.update_count) / wall_s,
+               (double)end * runs * LED_POLL_PERIOD_MS / 1000.0 / wall_s);
+    }
+
+#if LED_PULL_ENABLE
+    if (pull && replay_pull_check(end) != 0) failed++;
+#endif
+
+    free(g_pull);
+    free(g_push);
+    free(g_rec);
+
+    return (failed != 0 || unsupported != 0) ? 1 : 0;
+}
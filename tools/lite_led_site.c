@@ -0,0 +1,194 @@
+/**
+ * @file    lite_led_site.c
+ * @brief   Lite LED site simulation (host tool)
+ *
+ * Runs many engine contexts on one virtual clock: a site poll advances
+ * every context by LED_POLL_PERIOD_MS, the contexts being claimed one at a
+ * time by a pool of worker threads (lite_led_site_work()). Each context
+ * drives LED_NUM LEDs on the headless backend: one in eight breathes, one
+ * in eight blinks, the rest are on. The tool reports the wall time of the
+ * site polls (CLOCK_MONOTONIC) and the aggregate LED update rate; a site
+ * keeps up with real time while a poll takes less than LED_POLL_PERIOD_MS.
+ *
+ * LED ids are 8-bit, so a context holds at most LED_NUM LEDs and larger
+ * installations are split over contexts. Build with a lite_led_cfg.h that
+ * has LED_CONTEXT_ENABLE and LED_SIM_ENABLE; tools/lite_led_site.sh writes
+ * one and runs the simulation:
+ *   cc -std=c11 -O2 -Iinc -o lite_led_site tools/lite_led_site.c src/lite_led.c -lm -lpthread
+ * Usage:  lite_led_site [-c contexts] [-t ticks] [-w workers]
+ *   -c contexts  Contexts of the site (default: enough for 1000000 LEDs)
+ *   -t ticks     Site polls to run (default 100)
+ *   -w workers   Threads polling contexts, the main one included (default 4)
+ *
+ * @author  HughWu
+ * @date    2025-08-23
+ * @version 1.0
+ */
+
+#define _POSIX_C_SOURCE 200809L     // pthread_barrier_t, clock_gettime()
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lite_led.h"
+
+#if !LED_CONTEXT_ENABLE || !LED_SIM_ENABLE
+#error "lite_led_site needs LED_CONTEXT_ENABLE and LED_SIM_ENABLE"
+#endif
+
+#define SITE_WORKERS_MAX    (64)
+#define SITE_LEDS           (1000000u)
+
+static pthread_barrier_t g_site_start;
+static pthread_barrier_t g_site_done;
+static bool g_site_stop = false;
+
+/**
+ * @brief Read CLOCK_MONOTONIC in microseconds
+ */
+static uint64_t site_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/**
+ * @brief Worker thread: poll contexts in every site poll until stopped
+ */
+static void *site_worker(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        pthread_barrier_wait(&g_site_start);
+        if (g_site_stop) break;
+        while (lite_led_site_work()) {}
+        pthread_barrier_wait(&g_site_done);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Set up the LEDs of a context
+ */
+static int site_fill(led_ctx_t *ctx, size_t n)
+{
+    led_cfg_t cfg;
+    int err;
+
+    err = lite_led_ctx_init(ctx);
+    if (err == LED_ERROR_NONE) err = lite_led_ctx_select(ctx);
+    if (err == LED_ERROR_NONE) err = lite_led_sim_init();
+    for (uint8_t id = 0; id < LED_NUM && err == LED_ERROR_NONE; id++) {
+        memset(&cfg, 0, sizeof(cfg));
+        switch (id % 8) {
+        case 0:
+            cfg.mode = LED_MODE_BREATH;
+            cfg.fade_ms = 1000u + 10u * (uint32_t)((n * LED_NUM + id) % 200);
+            break;
+        case 1:
+            cfg.mode = LED_MODE_BLINK;
+            cfg.on_ms = 200u + 100u * (uint32_t)(n % 4);
+            cfg.off_ms = 300u;
+            break;
+        default:
+            cfg.mode = LED_MODE_ON;
+            break;
+        }
+        err = lite_led_write(id, &cfg);
+    }
+    lite_led_ctx_select(NULL);
+
+    return err;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t thread[SITE_WORKERS_MAX];
+    size_t contexts = (SITE_LEDS + LED_NUM - 1) / LED_NUM;
+    unsigned long ticks = 100;
+    size_t workers = 4;
+    led_ctx_t **ctx;
+    led_sim_report_t report;
+    uint64_t start;
+    bool usage = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            contexts = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            ticks = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            workers = strtoul(argv[++i], NULL, 0);
+        } else {
+            usage = true;
+        }
+    }
+    if (usage || contexts == 0 || ticks == 0 || workers == 0 || workers > SITE_WORKERS_MAX) {
+        fprintf(stderr, "usage: %s [-c contexts] [-t ticks] [-w workers]\n", argv[0]);
+        return 2;
+    }
+
+    ctx = calloc(contexts, sizeof(*ctx));
+    if (ctx == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (size_t n = 0; n < contexts; n++) {
+        ctx[n] = malloc(lite_led_ctx_size());
+        if (ctx[n] == NULL || site_fill(ctx[n], n) != LED_ERROR_NONE) {
+            fprintf(stderr, "cannot set up context %zu\n", n);
+            return 1;
+        }
+    }
+    if (lite_led_site_start(ctx, contexts) != LED_ERROR_NONE) {
+        fprintf(stderr, "cannot start the site\n");
+        return 1;
+    }
+
+    pthread_barrier_init(&g_site_start, NULL, (unsigned)workers);
+    pthread_barrier_init(&g_site_done, NULL, (unsigned)workers);
+    for (size_t w = 1; w < workers; w++) {
+        pthread_create(&thread[w], NULL, site_worker, NULL);
+    }
+
+    printf("%zu contexts of %u LEDs (%zu LEDs, %zu bytes each), %zu workers, %lu ticks\n", contexts,
+           (unsigned)LED_NUM, contexts * LED_NUM, lite_led_ctx_size(), workers, ticks);
+    start = site_us();
+    for (unsigned long t = 0; t < ticks; t++) {
+        lite_led_site_begin();
+        pthread_barrier_wait(&g_site_start);
+        while (lite_led_site_work()) {}
+        pthread_barrier_wait(&g_site_done);
+        lite_led_site_end();
+    }
+    lite_led_site_report(site_us() - start, &report);
+
+    g_site_stop = true;
+    pthread_barrier_wait(&g_site_start);
+    for (size_t w = 1; w < workers; w++) {
+        pthread_join(thread[w], NULL);
+    }
+
+    printf("%.1f ms simulated in %.3f s: %.2f ms per site poll (budget %u ms), %.2fx real time\n",
+           (double)report.sim_ms, report.wall_us / 1e6, report.wall_us / 1e3 / report.ticks,
+           (unsigned)LED_POLL_PERIOD_MS, report.speedup_x100 / 100.0);
+    printf("%llu updates (%llu changes, %llu bytes), %llu updates/s\n", (unsigned long long)report.updates,
+           (unsigned long long)report.changes, (unsigned long long)report.bytes,
+           (unsigned long long)report.updates_per_sec);
+
+    for (size_t n = 0; n < contexts; n++) {
+        free(ctx[n]);
+    }
+    free(ctx);
+
+    return 0;
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Lite LED site simulation
+#
+# Writes a copy of inc/lite_led_cfg.h with LEDS LEDs per context,
+# LED_CONTEXT_ENABLE and LED_SIM_ENABLE, builds tools/lite_led_site.c
+# against it and runs it once per worker count. Other arguments go to the
+# simulation.
+#
+# Usage: sh tools/lite_led_site.sh [-c contexts] [-t ticks]
+#        (LEDS=240, WORKERS="1 2 4 8", CC and CFLAGS are honoured)
+
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT INT TERM
+
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:--O2}
+LEDS=${LEDS:-240}
+WORKERS=${WORKERS:-1 2 4 8}
+
+ids=
+i=4
+while [ $i -lt "$LEDS" ]; do
+    ids="$ids LED_$i,"
+    i=$((i + 1))
+done
+
+cp "$root/inc/lite_led.h" "$work/"
+tr -d '\r' < "$root/inc/lite_led_cfg.h" | sed \
+    -e "s/^    LED_WHITE,\$/    LED_WHITE,$ids/" \
+    -e 's/^\(#define LED_CONTEXT_ENABLE  *\)([0-9]*)/\1(1)/' \
+    -e 's/^\(#define LED_SIM_ENABLE  *\)([0-9]*)/\1(1)/' > "$work/lite_led_cfg.h"
+$CC -std=c11 $CFLAGS -Wall -Wextra -I"$work" -o "$work/site" \
+    "$root/tools/lite_led_site.c" "$root/src/lite_led.c" -lm -lpthread
+
+echo "$(nproc 2>/dev/null || echo '?') CPUs online"
+for w in $WORKERS; do
+    "$work/site" -w "$w" "$@"
+    echo
+done